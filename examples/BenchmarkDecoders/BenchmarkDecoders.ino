@@ -0,0 +1,238 @@
+/*
+  RadiaCode Decoder Benchmark
+
+  This example measures the offline hot paths of the library on canned
+  payloads - no device needed. It reports:
+
+    - BytesBuffer write/read throughput
+    - decodeSpectrum() rate for the V0 (raw uint32) format
+    - decodeSpectrum() rate for the V1 (run/delta) format
+    - decodeDataBuf() record rate on a synthetic DATA_BUF payload
+
+  Run it before and after a change to quantify the effect on the target
+  hardware.
+*/
+
+#include <RadiaCode.h>
+#include <Decoders.h>
+#include <BytesBuffer.h>
+
+// Channels in the synthetic spectra (kept below the 4 KB buffer limit)
+static const size_t BENCH_CHANNELS = 1000;
+
+// Records in the synthetic DATA_BUF payload
+static const size_t BENCH_RECORDS = 32;
+
+// Iterations per benchmark
+static const uint32_t SPECTRUM_ITERS = 200;
+static const uint32_t DATABUF_ITERS = 500;
+static const uint32_t BUFFER_ITERS = 100;
+
+static void printRate(const char* label, uint32_t items, uint32_t iters, uint32_t elapsed_us)
+{
+    float per_iter_us = (float)elapsed_us / iters;
+    float per_sec = (elapsed_us > 0) ? (1.0e6f * items * iters / elapsed_us) : 0.0f;
+
+    Serial.print(label);
+    Serial.print(": ");
+    Serial.print(per_iter_us, 1);
+    Serial.print(" us/iteration, ");
+    Serial.print(per_sec, 0);
+    Serial.println(" items/s");
+}
+
+void benchBytesBuffer(void)
+{
+    Serial.println("------------------------");
+    Serial.println("BytesBuffer throughput...");
+
+    BytesBuffer buf;
+    const size_t WORDS = 1000;
+
+    uint32_t start = micros();
+    for (uint32_t iter = 0; iter < BUFFER_ITERS; iter++)
+    {
+        buf.reset();
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            buf.writeUint32(i);
+        }
+    }
+    uint32_t write_us = micros() - start;
+
+    uint32_t sink = 0;
+    start = micros();
+    for (uint32_t iter = 0; iter < BUFFER_ITERS; iter++)
+    {
+        buf.setPosition(0);
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            uint32_t v;
+            buf.readUint32(&v);
+            sink += v;
+        }
+    }
+    uint32_t read_us = micros() - start;
+
+    printRate("  writeUint32", WORDS, BUFFER_ITERS, write_us);
+    printRate("  readUint32", WORDS, BUFFER_ITERS, read_us);
+
+    // Bulk read path used by the V0 spectrum decoder
+    static uint32_t bulk[WORDS];
+    start = micros();
+    for (uint32_t iter = 0; iter < BUFFER_ITERS; iter++)
+    {
+        buf.setPosition(0);
+        buf.readUint32Array(bulk, WORDS);
+    }
+    uint32_t bulk_us = micros() - start;
+    printRate("  readUint32Array", WORDS, BUFFER_ITERS, bulk_us);
+
+    if (sink == 0xFFFFFFFF)
+    {
+        Serial.println(); // Keep the reads from being optimized away
+    }
+}
+
+// Build a spectrum payload: duration, a0..a2, then the channel data
+static void writeSpectrumHeader(BytesBuffer& buf)
+{
+    buf.writeUint32(600);    // duration_sec
+    buf.writeFloat(-5.0f);   // a0
+    buf.writeFloat(2.5f);    // a1
+    buf.writeFloat(0.0004f); // a2
+}
+
+void benchSpectrumV0(void)
+{
+    Serial.println("------------------------");
+    Serial.println("decodeSpectrum() V0 (raw uint32)...");
+
+    BytesBuffer buf;
+    writeSpectrumHeader(buf);
+    for (size_t i = 0; i < BENCH_CHANNELS; i++)
+    {
+        buf.writeUint32(1000 + (i % 37));
+    }
+
+    Spectrum spectrum;
+    uint32_t start = micros();
+    for (uint32_t iter = 0; iter < SPECTRUM_ITERS; iter++)
+    {
+        buf.setPosition(0);
+        decodeSpectrum(buf, 0, spectrum);
+    }
+    uint32_t elapsed = micros() - start;
+
+    Serial.print("  decoded channels per pass: ");
+    Serial.println(spectrum.count_size);
+    printRate("  V0 channels", spectrum.count_size, SPECTRUM_ITERS, elapsed);
+}
+
+void benchSpectrumV1(void)
+{
+    Serial.println("------------------------");
+    Serial.println("decodeSpectrum() V1 (run/delta encoded)...");
+
+    BytesBuffer buf;
+    writeSpectrumHeader(buf);
+
+    // A representative mix of runs: zero runs for the empty high end and
+    // int8-delta runs for the populated region, 64 channels per block
+    const uint16_t RUN = 64;
+    size_t written = 0;
+    bool zero_block = false;
+    while ((written + RUN) <= BENCH_CHANNELS)
+    {
+        if (zero_block)
+        {
+            buf.writeUint16((RUN << 4) | 0); // vlen 0: zero run, no payload
+        }
+        else
+        {
+            buf.writeUint16((RUN << 4) | 2); // vlen 2: int8 deltas
+            for (uint16_t i = 0; i < RUN; i++)
+            {
+                buf.writeUint8((uint8_t)(int8_t)((i % 7) - 3));
+            }
+        }
+        zero_block = !zero_block;
+        written += RUN;
+    }
+
+    Spectrum spectrum;
+    uint32_t start = micros();
+    for (uint32_t iter = 0; iter < SPECTRUM_ITERS; iter++)
+    {
+        buf.setPosition(0);
+        decodeSpectrum(buf, 1, spectrum);
+    }
+    uint32_t elapsed = micros() - start;
+
+    Serial.print("  decoded channels per pass: ");
+    Serial.println(spectrum.count_size);
+    printRate("  V1 channels", spectrum.count_size, SPECTRUM_ITERS, elapsed);
+}
+
+void benchDataBuf(void)
+{
+    Serial.println("------------------------");
+    Serial.println("decodeDataBuf() record rate...");
+
+    // Synthetic DATA_BUF payload of RealTimeData groups: 7-byte group
+    // header followed by the 15-byte record body
+    BytesBuffer buf;
+    for (size_t i = 0; i < BENCH_RECORDS; i++)
+    {
+        buf.writeUint8((uint8_t)i);      // seq
+        buf.writeUint8(0);               // eid
+        buf.writeUint8(0);               // gid: GRP_RealTimeData
+        buf.writeInt32((int32_t)i * 100); // ts_offset
+
+        buf.writeFloat(25.4f);           // count_rate
+        buf.writeFloat(0.12f);           // dose_rate
+        buf.writeUint16(15);             // count_rate_err (tenths)
+        buf.writeUint16(22);             // dose_rate_err (tenths)
+        buf.writeUint16(0);              // flags
+        buf.writeUint8(0);               // real_time_flags
+    }
+
+    static DataItemRecord records[BENCH_RECORDS];
+    size_t decoded = 0;
+
+    uint32_t start = micros();
+    for (uint32_t iter = 0; iter < DATABUF_ITERS; iter++)
+    {
+        buf.setPosition(0);
+        decoded = decodeDataBuf(buf, 0, records, BENCH_RECORDS);
+    }
+    uint32_t elapsed = micros() - start;
+
+    Serial.print("  decoded records per pass: ");
+    Serial.println(decoded);
+    printRate("  records", decoded, DATABUF_ITERS, elapsed);
+}
+
+void setup(void)
+{
+    // Initialize serial
+    Serial.begin(115200);
+    while (!Serial && millis() < 5000);
+
+    Serial.println("RadiaCode Decoder Benchmark");
+    Serial.println("------------------------");
+
+    benchBytesBuffer();
+    benchSpectrumV0();
+    benchSpectrumV1();
+    benchDataBuf();
+
+    Serial.println("------------------------");
+    Serial.println("Done.");
+}
+
+void loop(void)
+{
+    // All benchmarks run once in setup()
+    delay(10000);
+}
@@ -0,0 +1,194 @@
+/*
+  RadiaCode Round-Trip Benchmark
+
+  This example measures end-to-end command latency against a live device
+  over Bluetooth: spectrum() and dataBuf() round trips, broken down into
+  the instrumented phases (chunked write, notification wait, decode)
+  collected by RadiaCodePerf, plus the pipelined DATA_BUF poll where the
+  next radio exchange overlaps decoding. Use it to compare transport and
+  decoder changes across ESP32 variants with real radio timing included.
+*/
+
+#include <RadiaCode.h>
+#include <RadiaCodePerf.h>
+
+// Bluetooth MAC address
+const char* bluetoothMac = "52:43:06:70:24:67"; // Replace with your device's MAC address
+
+// Create RadiaCode instance
+RadiaCode* radiacode = nullptr;
+
+// Round trips per benchmark
+static const uint32_t ITERATIONS = 20;
+
+static void printStats(const char* label, const PerfStats& stats)
+{
+    Serial.print("  ");
+    Serial.print(label);
+    Serial.print(": n=");
+    Serial.print(stats.count);
+    Serial.print(" min=");
+    Serial.print(stats.min_us);
+    Serial.print("us max=");
+    Serial.print(stats.max_us);
+    Serial.print("us mean=");
+    Serial.print(stats.mean_us());
+    Serial.println("us");
+}
+
+static void printPhaseBreakdown(void)
+{
+    printStats("execute (end to end)", RadiaCodePerf::phase(PERF_EXECUTE));
+    printStats("transport write", RadiaCodePerf::phase(PERF_TRANSPORT_WRITE));
+    printStats("transport wait", RadiaCodePerf::phase(PERF_TRANSPORT_WAIT));
+    printStats("decode spectrum", RadiaCodePerf::phase(PERF_DECODE_SPECTRUM));
+    printStats("decode data buf", RadiaCodePerf::phase(PERF_DECODE_DATABUF));
+}
+
+void benchSpectrumRoundTrip(void)
+{
+    Serial.println("------------------------");
+    Serial.print("spectrum() x");
+    Serial.print(ITERATIONS);
+    Serial.println("...");
+
+    RadiaCodePerf::setEnabled(true); // Also clears earlier samples
+
+    uint32_t start = millis();
+    size_t channels = 0;
+    for (uint32_t i = 0; i < ITERATIONS; i++)
+    {
+        Spectrum s = radiacode->spectrum();
+        channels = s.count_size;
+    }
+    uint32_t elapsed = millis() - start;
+
+    Serial.print("  total: ");
+    Serial.print(elapsed);
+    Serial.print("ms (");
+    Serial.print((float)elapsed / ITERATIONS, 1);
+    Serial.print("ms per round trip, ");
+    Serial.print(channels);
+    Serial.println(" channels)");
+
+    printPhaseBreakdown();
+    RadiaCodePerf::setEnabled(false);
+}
+
+void benchDataBufRoundTrip(void)
+{
+    Serial.println("------------------------");
+    Serial.print("dataBuf() x");
+    Serial.print(ITERATIONS);
+    Serial.println("...");
+
+    RadiaCodePerf::setEnabled(true);
+
+    static DataItemRecord records[64];
+    uint32_t start = millis();
+    size_t total_records = 0;
+    for (uint32_t i = 0; i < ITERATIONS; i++)
+    {
+        total_records += radiacode->dataBuf(records, 64);
+        delay(200); // Let the device queue a few fresh records
+    }
+    uint32_t elapsed = millis() - start;
+
+    Serial.print("  total: ");
+    Serial.print(elapsed);
+    Serial.print("ms for ");
+    Serial.print(total_records);
+    Serial.println(" records (includes 200ms pacing delays)");
+
+    printPhaseBreakdown();
+    RadiaCodePerf::setEnabled(false);
+}
+
+void benchDataBufPipelined(void)
+{
+    Serial.println("------------------------");
+    Serial.print("dataBufPipelined() x");
+    Serial.print(ITERATIONS);
+    Serial.println("...");
+
+    if (!radiacode->startPipelinedDataBuf())
+    {
+        Serial.println("  transport has no pipelined mode, skipped");
+        return;
+    }
+
+    RadiaCodePerf::setEnabled(true);
+
+    static DataItemRecord records[64];
+    uint32_t start = millis();
+    size_t total_records = 0;
+    for (uint32_t i = 0; i < ITERATIONS; i++)
+    {
+        // The next poll is already in flight while these records are
+        // decoded and (in a real sketch) processed
+        total_records += radiacode->dataBufPipelined(records, 64);
+        delay(200); // Let the device queue a few fresh records
+    }
+    uint32_t elapsed = millis() - start;
+
+    radiacode->stopPipelinedDataBuf();
+
+    Serial.print("  total: ");
+    Serial.print(elapsed);
+    Serial.print("ms for ");
+    Serial.print(total_records);
+    Serial.println(" records (includes 200ms pacing delays)");
+
+    printPhaseBreakdown();
+    RadiaCodePerf::setEnabled(false);
+}
+
+void setup(void)
+{
+    // Initialize serial
+    Serial.begin(115200);
+    while (!Serial && millis() < 5000);
+
+    Serial.println("RadiaCode Round-Trip Benchmark");
+    Serial.println("------------------------");
+
+    try
+    {
+        Serial.println("Connecting via Bluetooth...");
+        radiacode = new RadiaCode(bluetoothMac);
+
+        String serialNum = radiacode->serialNumber();
+        if (serialNum.length() == 0)
+        {
+            Serial.println("Failed to get device serial number - connection failed!");
+            delete radiacode;
+            radiacode = nullptr;
+            return;
+        }
+
+        Serial.print("Connected to RadiaCode device: ");
+        Serial.println(serialNum);
+
+        benchSpectrumRoundTrip();
+        benchDataBufRoundTrip();
+        benchDataBufPipelined();
+
+        Serial.println("------------------------");
+        Serial.println("Done.");
+    }
+    catch (...)
+    {
+        Serial.println("Exception during RadiaCode initialization!");
+        if (radiacode != nullptr)
+        {
+            delete radiacode;
+            radiacode = nullptr;
+        }
+    }
+}
+
+void loop(void)
+{
+    // All benchmarks run once in setup()
+    delay(10000);
+}
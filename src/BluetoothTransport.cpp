@@ -21,6 +21,7 @@
 /**********************************************************************************/
 
 #include "BluetoothTransport.h"
+#include "RadiaCodePerf.h"
 
 #ifdef BT_SUPPORT_ENABLED
 
@@ -28,52 +29,137 @@
 #if defined(ARDUINO_ARCH_ESP32)
 #include <BLEDevice.h>
 #include <BLEClient.h>
+#include <Preferences.h>
 #endif
 
 // Debugging switches
 #undef  BT_DEBUG_INFO
 #define BT_DEBUG_WARNING
-
-// Define the static buffer for BluetoothTransport
-uint8_t BluetoothTransport::_resp_buffer[BluetoothTransport::MAX_RESP_SIZE];
 #endif
 
 BluetoothTransport::BluetoothTransport(const char* mac)
 {
+    // No fragment sink until a streaming decoder registers one
+    _frag_callback = nullptr;
+    _frag_ctx = nullptr;
+
 #ifdef BT_SUPPORT_ENABLED
     _resp_size = 0;
     _resp_received = 0;
     _response_ready = false;
+    _async_pending = false;
     // Initialize the buffer to zeros
     memset(_resp_buffer, 0, MAX_RESP_SIZE);
 
+    // Create the completion semaphore before notifications can fire
+    _response_sem = xSemaphoreCreateBinary();
+
+    // Pipeline state; the service task and its buffers are only created by
+    // startPipeline()
+    for (size_t i = 0; i < PIPELINE_DEPTH; i++)
+    {
+        _pipe_buffers[i] = nullptr;
+        _pipe_sizes[i] = 0;
+    }
+    _pipe_next = 0;
+    _pipeline_task = nullptr;
+    _request_queue = nullptr;
+    _response_queue = nullptr;
+    _pipeline_run = false;
+
+    // Assume the BLE 4.0 minimum until a larger MTU has been negotiated
+    _mtu = MIN_CHUNK_SIZE + 3;
+    _chunk_size = MIN_CHUNK_SIZE;
+
+    // No GATT objects resolved yet
+    _service = nullptr;
+    _write_char = nullptr;
+    _notify_char = nullptr;
+    _cached_mtu = 0;
+
     // Initialize BLE client - platform-specific code
 #if defined(ARDUINO_ARCH_ESP32)
+    // Resolve the peer address: an explicit MAC wins and refreshes the
+    // fast-reconnect cache; without one we fall back to the last peer we
+    // successfully connected to, so a wake from deep sleep does not need
+    // the sketch to supply the address again
+    char peer_mac[18];
+    bool have_peer = false;
+
+    if ((mac != nullptr) && (mac[0] != '\0'))
+    {
+        strncpy(peer_mac, mac, sizeof(peer_mac));
+        peer_mac[sizeof(peer_mac) - 1] = '\0';
+        have_peer = true;
+
+        // Still load the cache for the MTU negotiated last time
+        char ignored[18];
+        loadCachedPeer(ignored, sizeof(ignored));
+    }
+    else
+    {
+        have_peer = loadCachedPeer(peer_mac, sizeof(peer_mac));
+        if (!have_peer)
+        {
+            Serial.println("No MAC given and no cached RadiaCode peer to reconnect to");
+        }
+    }
+
     // ESP32 BLE initialization
     BLEDevice::init("RadiaCode Client");
+    // Request the MTU the peer granted last time when known, otherwise the
+    // preferred maximum; the actual value is negotiated during connect
+    BLEDevice::setMTU((_cached_mtu > (MIN_CHUNK_SIZE + 3)) ? _cached_mtu : PREFERRED_MTU);
     BLEClient* pClient = BLEDevice::createClient();
 
     // Connect to the RadiaCode device
-    BLEAddress bleAddress(mac);
-    if (pClient->connect(bleAddress))
+    bool connected = false;
+    if (have_peer)
+    {
+        BLEAddress bleAddress(peer_mac);
+        connected = pClient->connect(bleAddress);
+    }
+
+    if (connected)
     {
         _peripheral = (void*)pClient;
 
+        // Size write chunks from the negotiated MTU (3 bytes ATT header)
+        uint16_t mtu = pClient->getMTU();
+        if (mtu > (MIN_CHUNK_SIZE + 3))
+        {
+            _mtu = mtu;
+            _chunk_size = (size_t)mtu - 3;
+        }
+
+#ifdef BT_DEBUG_INFO
+        Serial.print("Negotiated MTU: ");
+        Serial.print(_mtu);
+        Serial.print(", write chunk size: ");
+        Serial.println(_chunk_size);
+#endif
+
         // Get service and characteristics
         BLEUUID serviceUUID("e63215e5-7003-49d8-96b0-b024798fb901");
         BLERemoteService* pService = pClient->getService(serviceUUID);
 
         if (pService != nullptr)
         {
+            _service = (void*)pService;
+
             // Get write characteristic
             BLEUUID writeUUID("e63215e6-7003-49d8-96b0-b024798fb901");
             BLERemoteCharacteristic* pWriteChar = pService->getCharacteristic(writeUUID);
             _write_handle = 0; // In ESP32, we use the characteristic directly
+            // Cache the resolved characteristic so sendRequest() never has
+            // to repeat the service lookup per request
+            _write_char = (void*)pWriteChar;
 
             // Get notify characteristic
             BLEUUID notifyUUID("e63215e7-7003-49d8-96b0-b024798fb901");
             BLERemoteCharacteristic* pNotifyChar = pService->getCharacteristic(notifyUUID);
             _notify_handle = 0; // In ESP32, we use the characteristic directly
+            _notify_char = (void*)pNotifyChar;
 
             // Set up notification callback
             if (pNotifyChar != nullptr)
@@ -81,6 +167,14 @@ BluetoothTransport::BluetoothTransport(const char* mac)
                 // Register for notifications
                 pNotifyChar->registerForNotify([this](BLERemoteCharacteristic* pChar, uint8_t* data, size_t length, bool isNotify)
                 {
+                    // Tee the raw fragment to a registered streaming decoder
+                    // before reassembly, so decoding overlaps the transfer
+                    FragmentCallback frag_cb = _frag_callback;
+                    if (frag_cb != nullptr)
+                    {
+                        frag_cb(_frag_ctx, data, length);
+                    }
+
                     // Handle notification data
                     if ((_resp_size == 0) && (length >= 4))
                     {
@@ -146,17 +240,29 @@ BluetoothTransport::BluetoothTransport(const char* mac)
                         Serial.print(_resp_size);
                         Serial.println(" bytes received");
 #endif
+                        // Wake a waiting execute() immediately
+                        if (_response_sem != nullptr)
+                        {
+                            xSemaphoreGive(_response_sem);
+                        }
                     }
                 });
 
                 // Enable notifications
                 pNotifyChar->getDescriptor(BLEUUID((uint16_t)0x2902))->writeValue((uint8_t*)"\x01\x00", 2);
+
+                // The connection is fully set up: remember this peer (and
+                // the MTU it granted) for the next wake cycle
+                storeCachedPeer(peer_mac);
             }
         }
     }
     else
     {
-        Serial.println("Failed to connect to BLE device");
+        if (have_peer)
+        {
+            Serial.println("Failed to connect to BLE device");
+        }
         _peripheral = nullptr;
     }
 #else
@@ -170,6 +276,9 @@ BluetoothTransport::BluetoothTransport(const char* mac)
 BluetoothTransport::~BluetoothTransport(void)
 {
 #ifdef BT_SUPPORT_ENABLED
+    // Shut down the service task before tearing down the connection it uses
+    stopPipeline();
+
     // Clean up BLE resources - platform-specific code
 #if defined(ARDUINO_ARCH_ESP32)
     if (_peripheral != nullptr)
@@ -182,18 +291,100 @@ BluetoothTransport::~BluetoothTransport(void)
     // Reset state variables
     _resp_size = 0;
     _resp_received = 0;
+
+    if (_response_sem != nullptr)
+    {
+        vSemaphoreDelete(_response_sem);
+        _response_sem = nullptr;
+    }
 #endif
 }
 
-BytesBuffer BluetoothTransport::execute(const uint8_t* request, size_t length)
+#ifdef BT_SUPPORT_ENABLED
+bool BluetoothTransport::loadCachedPeer(char* mac_out, size_t mac_len)
 {
-    BytesBuffer response;
+#if defined(ARDUINO_ARCH_ESP32)
+    if ((mac_out == nullptr) || (mac_len == 0))
+    {
+        return false;
+    }
 
-#ifdef BT_SUPPORT_ENABLED
+    Preferences prefs;
+    if (!prefs.begin("radiacode", true)) // Read-only
+    {
+        return false;
+    }
+
+    String cached_mac = prefs.getString("peer_mac", "");
+    _cached_mtu = prefs.getUShort("peer_mtu", 0);
+    prefs.end();
+
+    if (cached_mac.length() == 0)
+    {
+        return false;
+    }
+
+    strncpy(mac_out, cached_mac.c_str(), mac_len);
+    mac_out[mac_len - 1] = '\0';
+
+#ifdef BT_DEBUG_INFO
+    Serial.print("Fast-reconnect cache: peer ");
+    Serial.print(mac_out);
+    Serial.print(", last MTU ");
+    Serial.println(_cached_mtu);
+#endif
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void BluetoothTransport::storeCachedPeer(const char* mac)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    if ((mac == nullptr) || (mac[0] == '\0'))
+    {
+        return;
+    }
+
+    // Skip the flash write when nothing changed; NVS wear matters on
+    // loggers that wake every few seconds
+    if (_cached_mtu == _mtu)
+    {
+        Preferences check;
+        if (check.begin("radiacode", true))
+        {
+            String cached_mac = check.getString("peer_mac", "");
+            check.end();
+            if (cached_mac == mac)
+            {
+                return;
+            }
+        }
+    }
+
+    Preferences prefs;
+    if (!prefs.begin("radiacode", false))
+    {
+#ifdef BT_DEBUG_WARNING
+        Serial.println("Warning: Failed to open NVS for fast-reconnect cache");
+#endif
+        return;
+    }
+
+    prefs.putString("peer_mac", mac);
+    prefs.putUShort("peer_mtu", _mtu);
+    prefs.end();
+#endif
+}
+
+bool BluetoothTransport::sendRequest(const uint8_t* request, size_t length)
+{
     if (_peripheral == nullptr)
     {
         Serial.println("Bluetooth not connected");
-        return response;
+        return false;
     }
 
     // Reset response tracking
@@ -201,50 +392,142 @@ BytesBuffer BluetoothTransport::execute(const uint8_t* request, size_t length)
     _resp_size = 0;
     _response_ready = false;
 
+    // Drain any stale completion signal left over from an abandoned request
+    if (_response_sem != nullptr)
+    {
+        xSemaphoreTake(_response_sem, 0);
+    }
+
     // Send request in chunks - platform-specific code
 #if defined(ARDUINO_ARCH_ESP32)
-    BLEClient* pClient = (BLEClient*)_peripheral;
-    BLEUUID writeUUID("e63215e6-7003-49d8-96b0-b024798fb901");
-    BLERemoteService* pService = pClient->getService(BLEUUID("e63215e5-7003-49d8-96b0-b024798fb901"));
-    BLERemoteCharacteristic* pWriteChar = pService->getCharacteristic(writeUUID);
+    // Use the characteristic resolved at connect time; repeating the
+    // service lookup here used to cost a GATT traversal on every request
+    BLERemoteCharacteristic* pWriteChar = (BLERemoteCharacteristic*)_write_char;
 
-    // Send in chunks of 18 bytes (BLE MTU limitation)
-    const size_t chunkSize = 18;
-    for (size_t pos = 0; pos < length; pos += chunkSize)
+    if (pWriteChar == nullptr)
+    {
+        // Fallback: resolve (and cache) it now if connect did not manage to
+        BLEClient* pClient = (BLEClient*)_peripheral;
+        BLERemoteService* pService = pClient->getService(BLEUUID("e63215e5-7003-49d8-96b0-b024798fb901"));
+        if (pService != nullptr)
+        {
+            pWriteChar = pService->getCharacteristic(BLEUUID("e63215e6-7003-49d8-96b0-b024798fb901"));
+            _write_char = (void*)pWriteChar;
+        }
+    }
+
+    if (pWriteChar == nullptr)
+    {
+        Serial.println("Write characteristic not available");
+        return false;
+    }
+
+    // Send in MTU-sized chunks; with a negotiated MTU of 185-517 bytes most
+    // requests fit into a single write instead of many 20-byte fragments
+    for (size_t pos = 0; pos < length; pos += _chunk_size)
     {
         size_t remaining = length - pos;
-        size_t toSend = (remaining > chunkSize) ? chunkSize : remaining;
+        size_t toSend = (remaining > _chunk_size) ? _chunk_size : remaining;
+
+        pWriteChar->writeValue((uint8_t*)(request + pos), toSend);
 
-        uint8_t chunk[chunkSize];
-        memcpy(chunk, request + pos, toSend);
-        
-        pWriteChar->writeValue(chunk, toSend);
-        delay(5); // Small delay to avoid overwhelming the BLE stack
+        if ((pos + toSend) < length)
+        {
+            delay(5); // Small delay between chunks to avoid overwhelming the BLE stack
+        }
     }
 #endif
 
-    // Wait for response with timeout - extended to 30 seconds
-    unsigned long startTime = millis();
-    const unsigned long TIMEOUT_MS = 30000; // Increased timeout to 30 seconds
-    unsigned long elapsedTime = 0;
+    return true;
+}
 
-    while ((!_response_ready) && ((elapsedTime = (millis() - startTime)) < TIMEOUT_MS))
+BytesBuffer BluetoothTransport::buildResponse(void)
+{
+    BytesBuffer response;
+
+    // Create a zero-copy view over the reassembly buffer. The notify
+    // callback already assembled the complete response in _resp_buffer, so
+    // handing the decoders a read-only view avoids copying up to 4 KB per
+    // poll. The view is only valid until the next request starts writing
+    // into _resp_buffer - callers must decode before issuing another one,
+    // which RadiaCode's execute-then-decode flow guarantees.
+    if (_resp_received >= 4) // Make sure we have at least the header
     {
-#ifdef BT_DEBUG_INFO
-        // Print progress every 2 seconds
-        if ((elapsedTime % 2000) < 20)
+        // Skip the size field (first 4 bytes)
+        size_t dataSize = _resp_received - 4;
+
+        // Additional safety check to ensure we have valid data
+        if (dataSize > (MAX_RESP_SIZE - 4))
         {
-            Serial.print("Waiting for BLE response: ");
-            Serial.print(_resp_received);
-            Serial.print("/");
-            Serial.print(_resp_size > 0 ? _resp_size : '?');
-            Serial.print(" bytes (");
-            Serial.print(elapsedTime / 1000);
-            Serial.println("s)");
+#ifdef BT_DEBUG_WARNING
+            Serial.println("Warning: Invalid response size detected");
+#endif
+            dataSize = MAX_RESP_SIZE - 4;
         }
+
+        // Check BytesBuffer capacity limits
+        if (dataSize > BytesBuffer::MAX_BUFFER_SIZE)
+        {
+            dataSize = BytesBuffer::MAX_BUFFER_SIZE;
+#ifdef BT_DEBUG_WARNING
+            Serial.println("Warning: Truncating response to fit BytesBuffer");
 #endif
-        delay(50); // Less frequent polling
-        yield(); // Allow ESP32 background tasks to run
+        }
+
+        // Wrap the response data without copying it
+        response = BytesBuffer::view(_resp_buffer + 4, dataSize);
+    }
+
+    return response;
+}
+#endif
+
+BytesBuffer BluetoothTransport::execute(const uint8_t* request, size_t length)
+{
+    BytesBuffer response;
+
+#ifdef BT_SUPPORT_ENABLED
+    // A blocking call supersedes any async request still in flight
+    _async_pending = false;
+
+    // Time the chunked write phase when collection is on
+    uint32_t perf_start = RadiaCodePerf::enabled() ? RadiaCodePerf::now() : 0;
+
+    if (!sendRequest(request, length))
+    {
+        return response;
+    }
+
+    if (RadiaCodePerf::enabled())
+    {
+        uint32_t perf_sent = RadiaCodePerf::now();
+        RadiaCodePerf::record(PERF_TRANSPORT_WRITE, perf_sent - perf_start);
+        perf_start = perf_sent; // The wait phase starts here
+    }
+
+    // Wait for response with timeout - extended to 30 seconds.
+    // The notify callback gives the semaphore on the last fragment, so we
+    // wake the instant the response completes instead of polling.
+    const unsigned long TIMEOUT_MS = 30000; // Increased timeout to 30 seconds
+
+    if (_response_sem != nullptr)
+    {
+        xSemaphoreTake(_response_sem, pdMS_TO_TICKS(TIMEOUT_MS));
+    }
+    else
+    {
+        // Fallback: poll if semaphore creation failed
+        unsigned long startTime = millis();
+        while ((!_response_ready) && ((millis() - startTime) < TIMEOUT_MS))
+        {
+            delay(10);
+            yield(); // Allow ESP32 background tasks to run
+        }
+    }
+
+    if (RadiaCodePerf::enabled())
+    {
+        RadiaCodePerf::record(PERF_TRANSPORT_WAIT, RadiaCodePerf::now() - perf_start);
     }
 
     if (!_response_ready)
@@ -261,36 +544,327 @@ BytesBuffer BluetoothTransport::execute(const uint8_t* request, size_t length)
         return response;
     }
 
-    // Create BytesBuffer from response
-    if (_resp_received >= 4) // Make sure we have at least the header
+    response = buildResponse();
+#else
+    Serial.println("Bluetooth not supported on this platform");
+#endif
+
+    return response;
+}
+
+bool BluetoothTransport::executeAsync(const uint8_t* request, size_t length)
+{
+#ifdef BT_SUPPORT_ENABLED
+    // Refuse to overlap two requests on one connection
+    if (_async_pending && !_response_ready)
     {
-        // Skip the size field (first 4 bytes)
-        size_t dataSize = _resp_received - 4;
+#ifdef BT_DEBUG_WARNING
+        Serial.println("Warning: Async request already pending");
+#endif
+        return false;
+    }
 
-        // Additional safety check to ensure we have valid data
-        if (dataSize > (MAX_RESP_SIZE - 4))
-        {
+    if (!sendRequest(request, length))
+    {
+        _async_pending = false;
+        return false;
+    }
+
+    _async_pending = true;
+    return true;
+#else
+    Serial.println("Bluetooth not supported on this platform");
+    return false;
+#endif
+}
+
+bool BluetoothTransport::responseReady(void)
+{
+#ifdef BT_SUPPORT_ENABLED
+    return (_async_pending && _response_ready);
+#else
+    return false;
+#endif
+}
+
+BytesBuffer BluetoothTransport::takeResponse(void)
+{
+#ifdef BT_SUPPORT_ENABLED
+    if (!_async_pending || !_response_ready)
+    {
 #ifdef BT_DEBUG_WARNING
-            Serial.println("Warning: Invalid response size detected");
+        Serial.println("Warning: takeResponse() called with no completed response");
 #endif
-            dataSize = MAX_RESP_SIZE - 4;
+        return BytesBuffer();
+    }
+
+    _async_pending = false;
+    return buildResponse();
+#else
+    return BytesBuffer();
+#endif
+}
+
+void BluetoothTransport::setFragmentSink(FragmentCallback callback, void* ctx)
+{
+    // Set the context first so the notify callback never sees a callback
+    // with a stale context
+    _frag_ctx = ctx;
+    _frag_callback = callback;
+}
+
+bool BluetoothTransport::startPipeline(void)
+{
+#ifdef BT_SUPPORT_ENABLED
+    if (_pipeline_task != nullptr)
+    {
+        return true; // Already running
+    }
+
+    if (_peripheral == nullptr)
+    {
+#ifdef BT_DEBUG_WARNING
+        Serial.println("Warning: Cannot start pipeline without a connection");
+#endif
+        return false;
+    }
+
+    // Allocate the response ring only while the pipeline runs; 2 x 4 KB is
+    // too much RAM to carry for callers that never use it
+    for (size_t i = 0; i < PIPELINE_DEPTH; i++)
+    {
+        _pipe_buffers[i] = new uint8_t[MAX_RESP_SIZE];
+        _pipe_sizes[i] = 0;
+    }
+    _pipe_next = 0;
+
+    _request_queue = xQueueCreate(PIPELINE_DEPTH, sizeof(PipelineRequest));
+    _response_queue = xQueueCreate(PIPELINE_DEPTH, sizeof(uint8_t));
+
+    if ((_request_queue == nullptr) || (_response_queue == nullptr))
+    {
+#ifdef BT_DEBUG_WARNING
+        Serial.println("Warning: Failed to create pipeline queues");
+#endif
+        stopPipeline();
+        return false;
+    }
+
+    // Pin the service task to core 0 next to the BLE stack, leaving core 1
+    // (the Arduino loop task) free to decode
+    _pipeline_run = true;
+    BaseType_t created = xTaskCreatePinnedToCore(
+        pipelineTaskEntry,
+        "rc_transport",
+        4096,
+        this,
+        1,
+        &_pipeline_task,
+        0);
+
+    if (created != pdPASS)
+    {
+#ifdef BT_DEBUG_WARNING
+        Serial.println("Warning: Failed to create pipeline task");
+#endif
+        _pipeline_task = nullptr;
+        _pipeline_run = false;
+        stopPipeline();
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void BluetoothTransport::stopPipeline(void)
+{
+#ifdef BT_SUPPORT_ENABLED
+    if (_pipeline_task != nullptr)
+    {
+        // The task clears _pipeline_task on its way out; wait for that so
+        // the queues and buffers below are guaranteed unused
+        _pipeline_run = false;
+        while (_pipeline_task != nullptr)
+        {
+            vTaskDelay(pdMS_TO_TICKS(10));
         }
+    }
+    _pipeline_run = false;
 
-        // Check BytesBuffer capacity limits
-        if (dataSize > BytesBuffer::MAX_BUFFER_SIZE)
+    if (_request_queue != nullptr)
+    {
+        vQueueDelete(_request_queue);
+        _request_queue = nullptr;
+    }
+
+    if (_response_queue != nullptr)
+    {
+        vQueueDelete(_response_queue);
+        _response_queue = nullptr;
+    }
+
+    for (size_t i = 0; i < PIPELINE_DEPTH; i++)
+    {
+        if (_pipe_buffers[i] != nullptr)
         {
-            dataSize = BytesBuffer::MAX_BUFFER_SIZE;
+            delete[] _pipe_buffers[i];
+            _pipe_buffers[i] = nullptr;
+        }
+        _pipe_sizes[i] = 0;
+    }
+#endif
+}
+
+bool BluetoothTransport::pipelineSubmit(const uint8_t* request, size_t length)
+{
+#ifdef BT_SUPPORT_ENABLED
+    if ((_pipeline_task == nullptr) || (_request_queue == nullptr))
+    {
 #ifdef BT_DEBUG_WARNING
-            Serial.println("Warning: Truncating response to fit BytesBuffer");
+        Serial.println("Warning: pipelineSubmit() without a running pipeline");
 #endif
-        }
+        return false;
+    }
 
-        // Create a BytesBuffer with the response data
-        response = BytesBuffer(_resp_buffer + 4, dataSize);
+    if ((request == nullptr) || (length == 0) || (length > MAX_PIPE_REQ_SIZE))
+    {
+#ifdef BT_DEBUG_WARNING
+        Serial.println("Warning: Invalid request passed to pipelineSubmit()");
+#endif
+        return false;
     }
+
+    // Queued by value so the caller's buffer can be reused immediately
+    PipelineRequest req;
+    memcpy(req.data, request, length);
+    req.length = length;
+
+    return (xQueueSend(_request_queue, &req, 0) == pdTRUE);
 #else
-    Serial.println("Bluetooth not supported on this platform");
+    return false;
 #endif
+}
 
-    return response;
+bool BluetoothTransport::pipelineReceive(BytesBuffer& response_out, uint32_t timeout_ms)
+{
+#ifdef BT_SUPPORT_ENABLED
+    if (_response_queue == nullptr)
+    {
+        return false;
+    }
+
+    uint8_t index;
+    if (xQueueReceive(_response_queue, &index, pdMS_TO_TICKS(timeout_ms)) != pdTRUE)
+    {
+        return false;
+    }
+
+    if ((index >= PIPELINE_DEPTH) || (_pipe_buffers[index] == nullptr))
+    {
+#ifdef BT_DEBUG_WARNING
+        Serial.println("Warning: Invalid pipeline buffer index");
+#endif
+        return false;
+    }
+
+    // Zero-copy handoff: the view stays valid until the ring reuses this
+    // buffer, i.e. until one further response after it has completed
+    response_out = BytesBuffer::view(_pipe_buffers[index], _pipe_sizes[index]);
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef BT_SUPPORT_ENABLED
+void BluetoothTransport::pipelineTaskEntry(void* param)
+{
+    BluetoothTransport* self = (BluetoothTransport*)param;
+
+    if (self != nullptr)
+    {
+        self->pipelineTaskLoop();
+        // Signal stopPipeline() that the queues and buffers are now unused
+        self->_pipeline_task = nullptr;
+    }
+
+    vTaskDelete(nullptr);
 }
+
+void BluetoothTransport::pipelineTaskLoop(void)
+{
+    const uint32_t RESPONSE_TIMEOUT_MS = 30000;
+
+    while (_pipeline_run)
+    {
+        // Block briefly for the next request so shutdown stays responsive
+        PipelineRequest req;
+        if (xQueueReceive(_request_queue, &req, pdMS_TO_TICKS(100)) != pdTRUE)
+        {
+            continue;
+        }
+
+        if (!sendRequest(req.data, req.length))
+        {
+            continue;
+        }
+
+        // Wait for the notify callback to finish reassembly, in slices so a
+        // stop request does not hang on a dead peer for the full timeout
+        uint32_t waited_ms = 0;
+        while (_pipeline_run && !_response_ready && (waited_ms < RESPONSE_TIMEOUT_MS))
+        {
+            if (_response_sem != nullptr)
+            {
+                if (xSemaphoreTake(_response_sem, pdMS_TO_TICKS(1000)) == pdTRUE)
+                {
+                    break;
+                }
+                waited_ms += 1000;
+            }
+            else
+            {
+                vTaskDelay(pdMS_TO_TICKS(10));
+                waited_ms += 10;
+            }
+        }
+
+        if (!_response_ready)
+        {
+#ifdef BT_DEBUG_WARNING
+            if (_pipeline_run)
+            {
+                Serial.println("Warning: Pipeline response timeout");
+            }
+#endif
+            continue;
+        }
+
+        // Park the payload in the next ring buffer so the reassembly buffer
+        // is free for the next exchange while the consumer decodes this one
+        size_t dataSize = (_resp_received >= 4) ? (_resp_received - 4) : 0;
+        if (dataSize > (MAX_RESP_SIZE - 4))
+        {
+            dataSize = MAX_RESP_SIZE - 4;
+        }
+
+        memcpy(_pipe_buffers[_pipe_next], _resp_buffer + 4, dataSize);
+        _pipe_sizes[_pipe_next] = dataSize;
+
+        uint8_t index = (uint8_t)_pipe_next;
+        if (xQueueSend(_response_queue, &index, pdMS_TO_TICKS(1000)) == pdTRUE)
+        {
+            _pipe_next = (_pipe_next + 1) % PIPELINE_DEPTH;
+        }
+#ifdef BT_DEBUG_WARNING
+        else
+        {
+            Serial.println("Warning: Pipeline consumer stalled, response dropped");
+        }
+#endif
+    }
+}
+#endif
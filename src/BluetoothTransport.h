@@ -28,6 +28,10 @@
 
 #if defined(ARDUINO_ARCH_ESP32)
 #define BT_SUPPORT_ENABLED
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
 #endif
 
 class BluetoothTransport : public RadiaCodeTransport
@@ -37,21 +41,107 @@ class BluetoothTransport : public RadiaCodeTransport
         virtual ~BluetoothTransport(void);
         virtual BytesBuffer execute(const uint8_t* request, size_t length) override;
 
+        // Asynchronous interface: send now, collect the response later.
+        // The BLE notify callback reassembles the response in the background,
+        // so the caller's loop() keeps running while a transfer is in flight.
+        virtual bool executeAsync(const uint8_t* request, size_t length) override;
+        virtual bool responseReady(void) override;
+        virtual BytesBuffer takeResponse(void) override;
+
+        // Pipelined interface: a dedicated transport task pinned to core 0
+        // (next to the BLE stack) sends queued requests and parks completed
+        // responses in a small ring of buffers, handing them to the consumer
+        // through a FreeRTOS queue. The consumer - typically the Arduino
+        // loop task, which runs on core 1 - decodes one response while the
+        // radio exchange for the next is already in flight. A received view
+        // stays valid until the buffer ring wraps, i.e. until one further
+        // response has been received after it.
+        virtual bool startPipeline(void) override;
+        virtual void stopPipeline(void) override;
+        virtual bool pipelineSubmit(const uint8_t* request, size_t length) override;
+        virtual bool pipelineReceive(BytesBuffer& response_out, uint32_t timeout_ms) override;
+
+        // Raw fragment tee (see RadiaCodeTransport): the notify callback
+        // hands every received fragment to the sink before appending it to
+        // the reassembly buffer, so a streaming decoder can work in parallel
+        // with the remainder of the transfer
+        virtual void setFragmentSink(FragmentCallback callback, void* ctx) override;
+
     private:
+        // Fragment sink state; volatile because it is read from the BLE
+        // notify context while the caller's task sets and clears it
+        FragmentCallback volatile _frag_callback;
+        void* volatile _frag_ctx;
+
 #ifdef BT_SUPPORT_ENABLED
+        // Send the request in chunks and arm the response reassembly
+        bool sendRequest(const uint8_t* request, size_t length);
+        // Wrap the reassembled response buffer into a BytesBuffer
+        BytesBuffer buildResponse(void);
+
         // Platform-specific Bluetooth variables
         void* _peripheral; // Pointer to Bluetooth peripheral object
         int _write_handle;
         int _notify_handle;
 
+        // Resolved GATT objects, cached at connect time so the request hot
+        // path never repeats service and characteristic lookups
+        void* _service;
+        void* _write_char;
+        void* _notify_char;
+
+        // Fast-reconnect cache backed by NVS ("radiacode" namespace): the
+        // peer address and last negotiated MTU survive deep sleep, so wake
+        // cycles reconnect without the sketch re-supplying the address and
+        // request the MTU the peer is known to grant
+        uint16_t _cached_mtu;
+        bool loadCachedPeer(char* mac_out, size_t mac_len);
+        void storeCachedPeer(const char* mac);
+
+        // Negotiated ATT MTU and the resulting write chunk size (MTU - 3
+        // bytes of ATT header). Falls back to the BLE 4.0 minimum when the
+        // peer does not accept a larger MTU.
+        static const uint16_t PREFERRED_MTU = 517;
+        static const size_t MIN_CHUNK_SIZE = 20;
+        uint16_t _mtu;
+        size_t _chunk_size;
+
         // Use fixed buffer instead of dynamic allocation for response
         // Increased to 4K to handle larger responses
         static const size_t MAX_RESP_SIZE = 4096;
-        // Use static buffer to avoid stack overflow
-        static uint8_t _resp_buffer[MAX_RESP_SIZE];
+        // Per-instance reassembly buffer so several transports can have
+        // responses in flight concurrently; the transport itself lives on
+        // the heap, keeping this off the stack
+        uint8_t _resp_buffer[MAX_RESP_SIZE];
         size_t _resp_received;
         size_t _resp_size;
         bool _response_ready;
+        bool _async_pending;
+
+        // Signaled by the BLE notify callback when the last fragment lands,
+        // so execute() wakes immediately instead of polling with delay()
+        SemaphoreHandle_t _response_sem;
+
+        // Pipeline machinery (see startPipeline). Requests are queued by
+        // value; completed responses are double-buffered so the reassembly
+        // buffer is free for the next exchange while the consumer decodes.
+        static const size_t PIPELINE_DEPTH = 2;
+        static const size_t MAX_PIPE_REQ_SIZE = 256;
+        struct PipelineRequest
+        {
+            uint8_t data[MAX_PIPE_REQ_SIZE];
+            size_t length;
+        };
+        uint8_t* _pipe_buffers[PIPELINE_DEPTH]; // Allocated while the pipeline runs
+        size_t _pipe_sizes[PIPELINE_DEPTH];
+        size_t _pipe_next;
+        TaskHandle_t _pipeline_task;
+        QueueHandle_t _request_queue;
+        QueueHandle_t _response_queue;
+        volatile bool _pipeline_run;
+
+        static void pipelineTaskEntry(void* param);
+        void pipelineTaskLoop(void);
 #endif
 };
 
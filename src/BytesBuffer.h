@@ -37,6 +37,17 @@ class BytesBuffer
         BytesBuffer& operator=(const BytesBuffer& other);  // Assignment operator
         ~BytesBuffer(void);
 
+        // Create a non-owning, read-only view over caller-owned memory.
+        // No allocation and no copy is made: reads go straight to the given
+        // buffer and all write methods are refused. The caller must keep the
+        // underlying memory alive (and unmodified) for as long as the view -
+        // or any copy of it - is in use. Used for the zero-copy handoff of
+        // the transport's reassembly buffer to the decoders.
+        static BytesBuffer view(const uint8_t* data, size_t length);
+
+        // True if this buffer borrows its storage instead of owning it
+        bool isView(void) const;
+
         // Reading methods
         bool readUint8(uint8_t* value);
         bool readUint16(uint16_t* value);
@@ -49,6 +60,25 @@ class BytesBuffer
         bool peekBytes(uint8_t* buffer, size_t offset, size_t length);
         String readString(void);
 
+        // Allocation-free counterpart of readString(): copies the
+        // length-prefixed string into the caller's buffer (truncated to
+        // fit) and always NUL-terminates. The stream position advances
+        // past the whole encoded string even when truncating, so the
+        // following fields stay aligned. Returns the characters copied.
+        size_t readStringInto(char* dest, size_t dest_size);
+
+        // Bulk reading methods: a single bounds check and block copy instead
+        // of one call (with its own check and position update) per element.
+        // readUint32Array returns the number of whole uint32 values copied.
+        size_t readUint32Array(uint32_t* dest, size_t count);
+        // Expose a read-only span of the internal buffer at the current
+        // position and advance past it; no copy is made. The span stays valid
+        // for the lifetime of this buffer.
+        bool readByteSpan(const uint8_t** span, size_t length);
+        // Raw cursor at the current read position (for hand-rolled decoders
+        // that commit their progress back via setPosition())
+        const uint8_t* rawCursor(void) const;
+
         // Writing methods
         bool writeUint8(uint8_t value);
         bool writeUint16(uint16_t value);
@@ -70,13 +100,18 @@ class BytesBuffer
         const uint8_t* getData(void) const;
 
     private:
-        // Use static shared buffer to avoid stack overflow
-        static uint8_t _shared_buffer[MAX_BUFFER_SIZE];
-        // Pointer to the buffer we're using (shared or allocated)
+        // Per-instance heap buffer. Each BytesBuffer owns its own storage so
+        // several buffers (and thus several device connections) can coexist;
+        // keeping it on the heap avoids blowing the task stack. For views
+        // this instead points at borrowed, caller-owned memory.
         uint8_t* _fixed_data;
         size_t _size;
         size_t _capacity;
         size_t _position;
+        bool _owns_data; // false for views: no delete[], no writes
+
+        // Internal constructor used by view(); borrows instead of copying
+        BytesBuffer(const uint8_t* data, size_t length, bool borrow);
 
         bool ensureCapacity(size_t additionalBytes); // Returns false if capacity exceeded
 };
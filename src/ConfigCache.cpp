@@ -0,0 +1,276 @@
+/**********************************************************************************/
+/* Copyright (c) 2025 Markus Geiger                                               */
+/*                                                                                */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
+/* of this software and associated documentation files (the "Software"), to deal  */
+/* in the Software without restriction, including without limitation the rights   */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
+/* copies of the Software, and to permit persons to whom the Software is          */
+/* furnished to do so, subject to the following conditions:                       */
+/*                                                                                */
+/* The above copyright notice and this permission notice shall be included in all */
+/* copies or substantial portions of the Software.                                */
+/*                                                                                */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
+/* SOFTWARE.                                                                      */
+/**********************************************************************************/
+
+#include "ConfigCache.h"
+#include "RadiaCode.h"
+
+// Debugging switches
+#undef  CC_DEBUG_INFO
+#define CC_DEBUG_WARNING
+#define CC_DEBUG_ERROR
+
+ConfigCache::ConfigCache(void)
+{
+    _buffer = nullptr;
+    _entry_count = 0;
+    _valid = false;
+}
+
+ConfigCache::~ConfigCache(void)
+{
+    if (_buffer != nullptr)
+    {
+        delete[] _buffer;
+        _buffer = nullptr;
+    }
+}
+
+bool ConfigCache::load(RadiaCode& device)
+{
+    invalidate();
+
+    if (_buffer == nullptr)
+    {
+        _buffer = new char[MAX_CONFIG_SIZE];
+        if (_buffer == nullptr)
+        {
+#ifdef CC_DEBUG_ERROR
+            Serial.println("Error: Failed to allocate configuration cache buffer");
+#endif
+            return false;
+        }
+    }
+
+    size_t length = device.configuration(_buffer, MAX_CONFIG_SIZE);
+    if (length == 0)
+    {
+#ifdef CC_DEBUG_WARNING
+        Serial.println("Warning: Empty configuration, cache not loaded");
+#endif
+        return false;
+    }
+
+    buildIndex(length);
+    _valid = true;
+
+#ifdef CC_DEBUG_INFO
+    Serial.print("Info: Configuration cache loaded, ");
+    Serial.print(_entry_count);
+    Serial.println(" keys");
+#endif
+
+    return true;
+}
+
+void ConfigCache::invalidate(void)
+{
+    _entry_count = 0;
+    _valid = false;
+}
+
+bool ConfigCache::valid(void) const
+{
+    return _valid;
+}
+
+void ConfigCache::buildIndex(size_t length)
+{
+    size_t pos = 0;
+    _entry_count = 0;
+
+    while ((pos < length) && (_entry_count < MAX_ENTRIES))
+    {
+        // One line per iteration
+        size_t line_start = pos;
+        while ((pos < length) && (_buffer[pos] != '\n'))
+        {
+            pos++;
+        }
+        size_t line_end = pos;
+        if (pos < length)
+        {
+            pos++; // Skip the newline
+        }
+
+        // Strip a trailing carriage return
+        if ((line_end > line_start) && (_buffer[line_end - 1] == '\r'))
+        {
+            line_end--;
+        }
+
+        // Locate the separator; lines without one are not key=value pairs
+        size_t eq = line_start;
+        while ((eq < line_end) && (_buffer[eq] != '='))
+        {
+            eq++;
+        }
+        if ((eq == line_start) || (eq == line_end))
+        {
+            continue;
+        }
+
+        // Trim the key and terminate it in place over the separator or
+        // the padding before it
+        size_t key_end = eq;
+        while ((key_end > line_start) && (_buffer[key_end - 1] == ' '))
+        {
+            key_end--;
+        }
+        if (key_end == line_start)
+        {
+            continue;
+        }
+        _buffer[key_end] = '\0';
+
+        // Trim and terminate the value; empty values are indexed too, so
+        // get() can distinguish "present but empty" from "absent"
+        size_t value_start = eq + 1;
+        while ((value_start < line_end) && (_buffer[value_start] == ' '))
+        {
+            value_start++;
+        }
+        size_t value_end = line_end;
+        while ((value_end > value_start) && (_buffer[value_end - 1] == ' '))
+        {
+            value_end--;
+        }
+        _buffer[value_end] = '\0';
+
+        _entries[_entry_count].key_offset = (uint16_t)line_start;
+        _entries[_entry_count].value_offset = (uint16_t)value_start;
+        _entry_count++;
+    }
+
+#ifdef CC_DEBUG_WARNING
+    if (_entry_count >= MAX_ENTRIES)
+    {
+        Serial.println("Warning: Configuration has more keys than the cache index holds");
+    }
+#endif
+}
+
+const ConfigCache::Entry* ConfigCache::find(const char* key) const
+{
+    if (!_valid || (key == nullptr))
+    {
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < _entry_count; i++)
+    {
+        if (strcmp(_buffer + _entries[i].key_offset, key) == 0)
+        {
+            return &_entries[i];
+        }
+    }
+
+    return nullptr;
+}
+
+const char* ConfigCache::get(const char* key) const
+{
+    const Entry* entry = find(key);
+    if (entry == nullptr)
+    {
+        return nullptr;
+    }
+    return _buffer + entry->value_offset;
+}
+
+bool ConfigCache::getInt(const char* key, int32_t& value_out) const
+{
+    const char* value = get(key);
+    if ((value == nullptr) || (*value == '\0'))
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    long parsed = strtol(value, &end, 10);
+    if (end == value)
+    {
+        return false;
+    }
+
+    value_out = (int32_t)parsed;
+    return true;
+}
+
+bool ConfigCache::getFloat(const char* key, float& value_out) const
+{
+    const char* value = get(key);
+    if ((value == nullptr) || (*value == '\0'))
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    float parsed = strtof(value, &end);
+    if (end == value)
+    {
+        return false;
+    }
+
+    value_out = parsed;
+    return true;
+}
+
+bool ConfigCache::getBool(const char* key, bool& value_out) const
+{
+    const char* value = get(key);
+    if ((value == nullptr) || (*value == '\0'))
+    {
+        return false;
+    }
+
+    if ((value[0] >= '0') && (value[0] <= '9'))
+    {
+        value_out = (strtol(value, nullptr, 10) != 0);
+        return true;
+    }
+    if ((strcasecmp(value, "true") == 0) || (strcasecmp(value, "on") == 0))
+    {
+        value_out = true;
+        return true;
+    }
+    if ((strcasecmp(value, "false") == 0) || (strcasecmp(value, "off") == 0))
+    {
+        value_out = false;
+        return true;
+    }
+
+    return false;
+}
+
+size_t ConfigCache::size(void) const
+{
+    return _valid ? _entry_count : 0;
+}
+
+const char* ConfigCache::keyAt(size_t index) const
+{
+    if (!_valid || (index >= _entry_count))
+    {
+        return nullptr;
+    }
+    return _buffer + _entries[index].key_offset;
+}
@@ -0,0 +1,90 @@
+/**********************************************************************************/
+/* Copyright (c) 2025 Markus Geiger                                               */
+/*                                                                                */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
+/* of this software and associated documentation files (the "Software"), to deal  */
+/* in the Software without restriction, including without limitation the rights   */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
+/* copies of the Software, and to permit persons to whom the Software is          */
+/* furnished to do so, subject to the following conditions:                       */
+/*                                                                                */
+/* The above copyright notice and this permission notice shall be included in all */
+/* copies or substantial portions of the Software.                                */
+/*                                                                                */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
+/* SOFTWARE.                                                                      */
+/**********************************************************************************/
+
+#ifndef ConfigCache_h
+#define ConfigCache_h
+
+#include "Arduino.h"
+
+class RadiaCode;
+
+// Indexed cache over the device's CONFIGURATION text blob. The blob is a
+// few kilobytes of key=value lines; re-parsing it with String substring
+// searches for every parameter churns the heap on each query. This cache
+// fetches the blob once into an internally held buffer, NUL-terminates
+// the keys and values in place, and answers typed lookups with plain
+// pointer walks - no allocation after load().
+//
+// The cache does not track the connection: call load() after connecting
+// and invalidate() (or just load() again) after a reconnect, since the
+// device may have been reprovisioned in between.
+class ConfigCache
+{
+    public:
+        ConfigCache(void);
+        ~ConfigCache(void);
+
+        // Fetch the configuration from the device and rebuild the index,
+        // replacing any previous contents. Returns false if the fetch
+        // failed or produced an empty blob.
+        bool load(RadiaCode& device);
+
+        // Drop the index; lookups fail until the next load()
+        void invalidate(void);
+        bool valid(void) const;
+
+        // Raw value for a key, NUL-terminated, valid until the next
+        // load() or invalidate(); nullptr if the key is absent
+        const char* get(const char* key) const;
+
+        // Typed lookups; the output is untouched when the key is absent
+        // or its value does not parse
+        bool getInt(const char* key, int32_t& value_out) const;
+        bool getFloat(const char* key, float& value_out) const;
+        bool getBool(const char* key, bool& value_out) const;
+
+        // Index iteration, e.g. for dumping the provisioning state
+        size_t size(void) const;
+        const char* keyAt(size_t index) const;
+
+    private:
+        // Matches the transport's maximum response payload
+        static const size_t MAX_CONFIG_SIZE = 4096;
+        static const size_t MAX_ENTRIES = 160;
+
+        struct Entry
+        {
+            uint16_t key_offset;
+            uint16_t value_offset;
+        };
+
+        // Split the buffer into key=value lines, terminating in place
+        void buildIndex(size_t length);
+        const Entry* find(const char* key) const;
+
+        char* _buffer; // Allocated on first load()
+        Entry _entries[MAX_ENTRIES];
+        size_t _entry_count;
+        bool _valid;
+};
+
+#endif
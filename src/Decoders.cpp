@@ -1,520 +1,1239 @@
-/**********************************************************************************/
-/* Copyright (c) 2025 Markus Geiger                                               */
-/*                                                                                */
-/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
-/* of this software and associated documentation files (the "Software"), to deal  */
-/* in the Software without restriction, including without limitation the rights   */
-/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
-/* copies of the Software, and to permit persons to whom the Software is          */
-/* furnished to do so, subject to the following conditions:                       */
-/*                                                                                */
-/* The above copyright notice and this permission notice shall be included in all */
-/* copies or substantial portions of the Software.                                */
-/*                                                                                */
-/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
-/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
-/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
-/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
-/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
-/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
-/* SOFTWARE.                                                                      */
-/**********************************************************************************/
-
-#include "Decoders.h"
-#include "BytesBuffer.h"
-#include "RadiaCodeTypes.h"
-
-// Debugging switches
-#undef  DEC_DEBUG_INFO
-#define DEC_DEBUG_WARNING
-#define DEC_DEBUG_ERROR
-
-// Helper function for spectrum decoding (version 0)
-void decodeCountsV0(BytesBuffer& br, Spectrum& spectrum)
-{
-    // Clear the counts before starting
-    spectrum.count_size = 0;
-
-    // Safety check - make sure we have data available
-    if (br.available() < sizeof(uint32_t))
-    {
-#ifdef DEC_DEBUG_WARNING
-        Serial.println("Warning: Not enough data for spectrum decoding (V0)");
-#endif
-        return;
-    }
-
-    // Read in the counts until we run out of data or reach MAX_CHANNELS
-    while ((br.available() > 0) && (br.available() >= sizeof(uint32_t)) && 
-           (spectrum.count_size < Spectrum::MAX_CHANNELS))
-    {
-        uint32_t count;
-        if (br.readUint32(&count))
-        {
-            // Double-check bounds before writing
-            if (spectrum.count_size < Spectrum::MAX_CHANNELS)
-            {
-                spectrum.counts[spectrum.count_size++] = count;
-            }
-            else
-            {
-#ifdef DEC_DEBUG_WARNING
-                Serial.println("Warning: Reached maximum spectrum channels");
-#endif
-                break;
-            }
-        }
-        else
-        {
-#ifdef DEC_DEBUG_ERROR
-            Serial.println("Error reading uint32 in decodeCountsV0");
-#endif
-            break;
-        }
-    }
-}
-
-// Helper function for spectrum decoding (version 1)
-void decodeCountsV1(BytesBuffer& br, Spectrum& spectrum)
-{
-    // Clear the counts before starting
-    spectrum.count_size = 0;
-    uint32_t last = 0;
-
-    // Safety check - make sure we have data available
-    if (br.available() < sizeof(uint16_t))
-    {
-#ifdef DEC_DEBUG_WARNING
-        Serial.println("Warning: Not enough data for spectrum decoding");
-#endif
-        return;
-    }
-
-    while ((br.available() >= sizeof(uint16_t)) && (spectrum.count_size < Spectrum::MAX_CHANNELS))
-    {
-        uint16_t u16;
-        if (!br.readUint16(&u16))
-        {
-#ifdef DEC_DEBUG_ERROR
-            Serial.println("Error reading u16 in decodeCountsV1");
-#endif
-            break;
-        }
-
-        uint16_t cnt = (u16 >> 4) & 0x0FFF;
-        uint8_t vlen = u16 & 0x0F;
-
-        // Add safety check for unreasonable count values
-        if (cnt > 4096)
-        {
-#ifdef DEC_DEBUG_WARNING
-            Serial.print("Warning: Suspicious count value in spectrum: ");
-            Serial.println(cnt);
-#endif
-            cnt = 0; // Skip this block
-        }
-
-        for (uint16_t i = 0; i < cnt && spectrum.count_size < Spectrum::MAX_CHANNELS; i++)
-        {
-            uint32_t v = 0;
-
-            if (vlen == 0)
-            {
-                v = 0;
-            }
-            else if (vlen == 1)
-            {
-                uint8_t val;
-                if (!br.readUint8(&val))
-                {
-#ifdef DEC_DEBUG_ERROR
-                    Serial.println("Error reading uint8 in decodeCountsV1");
-#endif
-                    goto end_decoding;
-                }
-                v = val;
-            }
-            else if (vlen == 2)
-            {
-                int8_t val;
-                if (!br.readInt8(&val))
-                {
-#ifdef DEC_DEBUG_ERROR
-                    Serial.println("Error reading int8 in decodeCountsV1");
-#endif
-                    goto end_decoding;
-                }
-                v = last + val;
-            }
-            else if (vlen == 3)
-            {
-                int16_t val;
-                if (!br.readInt16(&val))
-                {
-#ifdef DEC_DEBUG_ERROR
-                    Serial.println("Error reading int16 in decodeCountsV1");
-#endif
-                    goto end_decoding;
-                }
-                v = last + val;
-            }
-            else if (vlen == 4)
-            {
-                if (br.available() < 3)
-                {
-#ifdef DEC_DEBUG_ERROR
-                    Serial.println("Error: Not enough data for vlen=4");
-#endif
-                    goto end_decoding;
-                }
-                uint8_t a, b;
-                int8_t c;
-                if ((!br.readUint8(&a)) || (!br.readUint8(&b)) || (!br.readInt8(&c)))
-                {
-#ifdef DEC_DEBUG_ERROR
-                    Serial.println("Error reading 3-byte value in decodeCountsV1");
-#endif
-                    goto end_decoding;
-                }
-                v = last + ((c << 16) | (b << 8) | a);
-            }
-            else if (vlen == 5)
-            {
-                int32_t val;
-                if (!br.readInt32(&val))
-                {
-#ifdef DEC_DEBUG_ERROR
-                    Serial.println("Error reading int32 in decodeCountsV1");
-#endif
-                    goto end_decoding;
-                }
-                v = last + val;
-            }
-            else
-            {
-#ifdef DEC_DEBUG_ERROR
-                Serial.print("Error: Unsupported vlen in decodeCountsV1: ");
-                Serial.println(vlen);
-#endif
-                break;
-            }
-
-            last = v;
-
-            // Extra safety check before adding to spectrum
-            if (spectrum.count_size < Spectrum::MAX_CHANNELS)
-            {
-                spectrum.counts[spectrum.count_size++] = v;
-            }
-        }
-    }
-
-end_decoding:
-    ; // Null statement to avoid syntax error
-    // No additional cleanup needed
-}
-
-void decodeSpectrum(BytesBuffer& br, uint8_t format_version, Spectrum& spectrum)
-{
-    // Clear the spectrum to start with a clean state
-    spectrum.clear();
-
-    // Check if we have enough data for the spectrum header
-    // We need 4 bytes for duration and 3x4 bytes for a0, a1, a2
-    if (br.available() < (4 + 3*4))
-    {
-#ifdef DEC_DEBUG_ERROR
-        Serial.println("Error: Not enough data for spectrum header");
-#endif
-        return;
-    }
-
-    // Read spectrum header with error checking
-    uint32_t duration;
-    if (!br.readUint32(&duration))
-    {
-#ifdef DEC_DEBUG_ERROR
-        Serial.println("Error reading spectrum duration");
-#endif
-        return;
-    }
-
-    float a0, a1, a2;
-    if ((!br.readFloat(&a0)) || (!br.readFloat(&a1)) || (!br.readFloat(&a2)))
-    {
-#ifdef DEC_DEBUG_ERROR
-        Serial.println("Error reading spectrum calibration coefficients");
-#endif
-        return;
-    }
-
-    // Only assign values after we've successfully read them
-    spectrum.duration_sec = duration;
-    spectrum.a0 = a0;
-    spectrum.a1 = a1;
-    spectrum.a2 = a2;
-
-    // Decode counts based on format version
-    if (format_version == 0)
-    {
-        decodeCountsV0(br, spectrum);
-    }
-    else if (format_version == 1)
-    {
-        decodeCountsV1(br, spectrum);
-    }
-    else
-    {
-#ifdef DEC_DEBUG_WARNING
-        Serial.print("Warning: Unsupported spectrum format version: ");
-        Serial.println(format_version);
-#endif
-    }
-
-    // Add a safety check on the count_size
-    if (spectrum.count_size > Spectrum::MAX_CHANNELS)
-    {
-#ifdef DEC_DEBUG_ERROR
-        Serial.println("Error: Spectrum count_size exceeds MAX_CHANNELS!");
-#endif
-        spectrum.count_size = Spectrum::MAX_CHANNELS;
-    }
-}
-
-std::vector<DataItem*> decodeDataBuf(BytesBuffer& br, uint32_t base_time_sec)
-{
-    std::vector<DataItem*> ret;
-    uint8_t next_seq = 0; // Initialize to invalid value
-    bool first_packet = true;
-
-    while (br.available() >= 7)
-    {
-        uint8_t seq, eid, gid;
-        int32_t ts_offset;
-
-        br.readUint8(&seq);
-        br.readUint8(&eid);
-        br.readUint8(&gid);
-        br.readInt32(&ts_offset);
-
-        // Calculate timestamp
-        uint32_t timestamp = base_time_sec + (ts_offset * 10) / 1000;
-
-        // Check sequence number
-        if (!first_packet && (next_seq != seq))
-        {
-            // Only print sequence jump message occasionally to reduce spam
-            static uint32_t last_seq_warning = 0;
-            if ((millis() - last_seq_warning) > 10000) // Every 10 seconds max
-            {
-#ifdef DEC_DEBUG_ERROR
-                Serial.print("Error: Sequence jump detected, expected: ");
-                Serial.print(next_seq);
-                Serial.print(", got: ");
-                Serial.println(seq);
-#endif
-                last_seq_warning = millis();
-            }
-            // Continue processing instead of breaking - sequence jumps are not critical
-            next_seq = seq; // Resync to current sequence
-        }
-        first_packet = false;
-        next_seq = (seq + 1) % 256;
-
-        if ((eid == 0) && (gid == 0)) // GRP_RealTimeData
-        {
-            RealTimeData* data = new RealTimeData();
-            data->timestamp = timestamp;
-
-            br.readFloat(&data->count_rate);
-            // dose_rate should be read as float, not uint16_t
-            br.readFloat(&data->dose_rate);  // Read as float directly, no conversion needed
-
-            // count_rate_err and dose_rate_err are float in RealTimeData
-            uint16_t tempCountRateErr, tempDoseRateErr;
-            br.readUint16(&tempCountRateErr);
-            br.readUint16(&tempDoseRateErr);
-            data->count_rate_err = tempCountRateErr;
-            data->dose_rate_err = tempDoseRateErr;
-
-            br.readUint16(&data->flags);
-            br.readUint8(&data->real_time_flags);
-
-            // Convert errors from raw values
-            data->count_rate_err /= 10.0f;
-            data->dose_rate_err /= 10.0f;
-
-            ret.push_back(data);
-        }
-        else if ((eid == 0) && (gid == 1)) // GRP_RawData
-        {
-            RawData* data = new RawData();
-            data->timestamp = timestamp;
-
-            br.readFloat(&data->count_rate);
-            br.readFloat(&data->dose_rate);
-
-            ret.push_back(data);
-        }
-        else if ((eid == 0) && (gid == 2)) // GRP_DoseRateDB
-        {
-            DoseRateDB* data = new DoseRateDB();
-            data->timestamp = timestamp;
-
-            br.readUint32(&data->count);
-            br.readFloat(&data->count_rate);
-            br.readFloat(&data->dose_rate);
-
-            // dose_rate_err is float in DoseRateDB
-            uint16_t tempDoseRateErr;
-            br.readUint16(&tempDoseRateErr);
-            data->dose_rate_err = tempDoseRateErr;
-
-            br.readUint16(&data->flags);
-
-            // Convert error from raw value
-            data->dose_rate_err /= 10.0f;
-
-            ret.push_back(data);
-        }
-        else if ((eid == 0) && (gid == 3)) // GRP_RareData
-        {
-            RareData* data = new RareData();
-            data->timestamp = timestamp;
-
-            br.readUint32(&data->duration);
-            br.readFloat(&data->dose);
-
-            uint16_t temperature, charge_level;
-            br.readUint16(&temperature);
-            br.readUint16(&charge_level);
-            br.readUint16(&data->flags);
-
-            // Convert raw values to actual values
-            data->temperature = (temperature - 2000) / 100.0f;
-            data->charge_level = charge_level / 100.0f;
-
-            ret.push_back(data);
-        }
-        else if ((eid == 0) && (gid == 7)) // GRP_Event
-        {
-            Event* data = new Event();
-            data->timestamp = timestamp;
-
-            uint8_t event_id;
-            br.readUint8(&event_id);
-            data->event = static_cast<EventId>(event_id);
-
-            br.readUint8(&data->event_param1);
-            br.readUint16(&data->flags);
-
-            ret.push_back(data);
-        }
-        else if ((eid == 0) && (gid == 9)) // GRP_RawDoseRate - might contain dose rate data
-        {
-            // Create a RawData object to store the dose rate
-            RawData* data = new RawData();
-            data->timestamp = timestamp;
-
-            float dose_rate;
-            uint16_t flags;
-            br.readFloat(&dose_rate);
-            br.readUint16(&flags);
-
-            // Set count_rate to 0 since this packet only contains dose_rate
-            data->count_rate = 0.0f;
-            data->dose_rate = dose_rate;
-
-#ifdef DEC_DEBUG_INFO
-            // Debug: Print when we find dose rate data
-            Serial.print("Found RawDoseRate: ");
-            Serial.print(dose_rate);
-            Serial.println(" µR/h");
-#endif
-
-            ret.push_back(data);
-        }
-        else
-        {
-            // Skip unknown data types - read and discard based on known patterns
-            if ((eid == 0) && (gid == 4)) // GRP_UserData
-            {
-                uint32_t count;
-                float count_rate, dose_rate;
-                uint16_t dose_rate_err, flags;
-                br.readUint32(&count);
-                br.readFloat(&count_rate);
-                br.readFloat(&dose_rate);
-                br.readUint16(&dose_rate_err);
-                br.readUint16(&flags);
-            }
-            else if ((eid == 0) && (gid == 5)) // GRP_ScheduleData
-            {
-                uint32_t count;
-                float count_rate, dose_rate;
-                uint16_t dose_rate_err, flags;
-                br.readUint32(&count);
-                br.readFloat(&count_rate);
-                br.readFloat(&dose_rate);
-                br.readUint16(&dose_rate_err);
-                br.readUint16(&flags);
-            }
-            else if ((eid == 0) && (gid == 6)) // GRP_AccelData
-            {
-                uint16_t acc_x, acc_y, acc_z;
-                br.readUint16(&acc_x);
-                br.readUint16(&acc_y);
-                br.readUint16(&acc_z);
-            }
-            else if ((eid == 0) && (gid == 8)) // GRP_RawCountRate
-            {
-                float count_rate;
-                uint16_t flags;
-                br.readFloat(&count_rate);
-                br.readUint16(&flags);
-            }
-            else if ((eid == 1) && (gid == 1))
-            {
-                uint16_t samples_num;
-                uint32_t smpl_time_ms;
-                br.readUint16(&samples_num);
-                br.readUint32(&smpl_time_ms);
-
-                // Skip 8 bytes per sample
-                br.setPosition(br.getPosition() + 8 * samples_num);
-            }
-            else if ((eid == 1) && (gid == 2))
-            {
-                uint16_t samples_num;
-                uint32_t smpl_time_ms;
-                br.readUint16(&samples_num);
-                br.readUint32(&smpl_time_ms);
-
-                // Skip 16 bytes per sample
-                br.setPosition(br.getPosition() + 16 * samples_num);
-            }
-            else if ((eid == 1) && (gid == 3))
-            {
-                uint16_t samples_num;
-                uint32_t smpl_time_ms;
-                br.readUint16(&samples_num);
-                br.readUint32(&smpl_time_ms);
-
-                // Skip 14 bytes per sample
-                br.setPosition(br.getPosition() + 14 * samples_num);
-            }
-            else
-            {
-#ifdef DEC_DEBUG_WARNING
-                Serial.print("Warning: Unknown data type: eid=");
-                Serial.print(eid);
-                Serial.print(", gid=");
-                Serial.println(gid);
-#endif
-                break; // Stop processing on unknown data type
-            }
-        }
-    }
-
-    return ret;
-}
+/**********************************************************************************/
+/* Copyright (c) 2025 Markus Geiger                                               */
+/*                                                                                */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
+/* of this software and associated documentation files (the "Software"), to deal  */
+/* in the Software without restriction, including without limitation the rights   */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
+/* copies of the Software, and to permit persons to whom the Software is          */
+/* furnished to do so, subject to the following conditions:                       */
+/*                                                                                */
+/* The above copyright notice and this permission notice shall be included in all */
+/* copies or substantial portions of the Software.                                */
+/*                                                                                */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
+/* SOFTWARE.                                                                      */
+/**********************************************************************************/
+
+#include "Decoders.h"
+#include "BytesBuffer.h"
+#include "RadiaCodeTypes.h"
+#include "RadiaCodePerf.h"
+
+// Debugging switches
+#undef  DEC_DEBUG_INFO
+#define DEC_DEBUG_WARNING
+#define DEC_DEBUG_ERROR
+
+// Encoded bytes per value for each vlen variant of the V1 count format
+static const uint8_t VLEN_BYTES[6] = {0, 1, 1, 2, 3, 4};
+
+const char* frameErrorName(FrameError error)
+{
+    switch (error)
+    {
+        case FRAME_OK:         return "ok";
+        case FRAME_TOO_SHORT:  return "too short";
+        case FRAME_BAD_FORMAT: return "bad format";
+        case FRAME_BAD_HEADER: return "bad header";
+        case FRAME_TRUNCATED:  return "truncated";
+    }
+    return "unknown";
+}
+
+FrameError validateSpectrumFrame(const BytesBuffer& br, uint8_t format_version)
+{
+    // Fixed header: duration plus the three calibration coefficients
+    if (br.available() < (4 + 3 * 4))
+    {
+        return FRAME_TOO_SHORT;
+    }
+
+    if (format_version == 0)
+    {
+        // Raw uint32 counts; any length is structurally fine (a stray
+        // trailing byte from the firmware is tolerated by the decoder)
+        return FRAME_OK;
+    }
+
+    if (format_version != 1)
+    {
+        return FRAME_BAD_FORMAT;
+    }
+
+    // Walk the V1 run headers and check every run against the frame end
+    const uint8_t* p = br.rawCursor() + 16;
+    const uint8_t* end = br.rawCursor() + br.available();
+
+    while ((size_t)(end - p) >= sizeof(uint16_t))
+    {
+        uint16_t u16 = (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+        p += 2;
+
+        uint16_t cnt = (u16 >> 4) & 0x0FFF;
+        uint8_t vlen = u16 & 0x0F;
+
+        if (vlen > 5)
+        {
+            return FRAME_BAD_HEADER;
+        }
+        if ((size_t)(end - p) < ((size_t)cnt * VLEN_BYTES[vlen]))
+        {
+            return FRAME_TRUNCATED;
+        }
+        p += (size_t)cnt * VLEN_BYTES[vlen];
+    }
+
+    return FRAME_OK;
+}
+
+FrameError validateDataBufFrame(const BytesBuffer& br)
+{
+    const uint8_t* p = br.rawCursor();
+    const uint8_t* end = p + br.available();
+
+    // Groups shorter than their 7-byte header terminate the decode loop
+    // cleanly, so a trailing remainder is tolerated here as well
+    while ((size_t)(end - p) >= 7)
+    {
+        uint8_t eid = p[1];
+        uint8_t gid = p[2];
+        p += 7;
+
+        size_t body = 0;
+        if (eid == 0)
+        {
+            switch (gid)
+            {
+                case 0: body = 15; break; // RealTimeData
+                case 1: body = 8;  break; // RawData
+                case 2: body = 16; break; // DoseRateDB
+                case 3: body = 14; break; // RareData
+                case 4: body = 16; break; // UserData
+                case 5: body = 16; break; // ScheduleData
+                case 6: body = 6;  break; // AccelData
+                case 7: body = 4;  break; // Event
+                case 8: body = 6;  break; // RawCountRate
+                case 9: body = 6;  break; // RawDoseRate
+                default:
+                    // Unknown group id: the end of the validatable prefix,
+                    // not corruption - newer firmware adds group types, and
+                    // the decoder stops cleanly at the first one it does
+                    // not know. Everything before it checked out.
+                    return FRAME_OK;
+            }
+        }
+        else if ((eid == 1) && (gid >= 1) && (gid <= 3))
+        {
+            // Sampled groups: sample count, sample interval, then a fixed
+            // stride per sample
+            if ((size_t)(end - p) < 6)
+            {
+                return FRAME_TRUNCATED;
+            }
+            uint16_t samples_num = (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+            static const uint8_t SAMPLE_STRIDE[4] = {0, 8, 16, 14};
+            body = 6 + (size_t)samples_num * SAMPLE_STRIDE[gid];
+        }
+        else
+        {
+            // Unknown eid/gid pair: end of the validatable prefix (see above)
+            return FRAME_OK;
+        }
+
+        if ((size_t)(end - p) < body)
+        {
+            return FRAME_TRUNCATED;
+        }
+        p += body;
+    }
+
+    return FRAME_OK;
+}
+
+// Helper function for spectrum decoding (version 0)
+void decodeCountsV0(BytesBuffer& br, Spectrum& spectrum)
+{
+    // Clear the counts before starting
+    spectrum.count_size = 0;
+
+    // Safety check - make sure we have data available
+    if (br.available() < sizeof(uint32_t))
+    {
+#ifdef DEC_DEBUG_WARNING
+        Serial.println("Warning: Not enough data for spectrum decoding (V0)");
+#endif
+        return;
+    }
+
+    // Bulk-read the counts in one block operation instead of one
+    // bounds-checked readUint32() call per channel
+    size_t channels = br.available() / sizeof(uint32_t);
+    if (channels > Spectrum::MAX_CHANNELS)
+    {
+#ifdef DEC_DEBUG_WARNING
+        Serial.println("Warning: Reached maximum spectrum channels");
+#endif
+        channels = Spectrum::MAX_CHANNELS;
+    }
+
+    spectrum.count_size = br.readUint32Array(spectrum.counts, channels);
+}
+
+// Helper function for spectrum decoding (version 1)
+void decodeCountsV1(BytesBuffer& br, Spectrum& spectrum)
+{
+    // Clear the counts before starting
+    spectrum.count_size = 0;
+    uint32_t last = 0;
+
+    // Safety check - make sure we have data available
+    if (br.available() < sizeof(uint16_t))
+    {
+#ifdef DEC_DEBUG_WARNING
+        Serial.println("Warning: Not enough data for spectrum decoding");
+#endif
+        return;
+    }
+
+    // Decode with raw pointer arithmetic instead of one bounds-checked
+    // read call per byte: each run is validated against the end of the
+    // buffer once up front, then its values are unpacked straight into the
+    // counts array. This loop is the top CPU consumer during acquisition
+    // bursts, and per-byte readUint8() calls dominated it.
+    const uint8_t* start = br.rawCursor();
+    const uint8_t* p = start;
+    const uint8_t* end = start + br.available();
+
+    while (((size_t)(end - p) >= sizeof(uint16_t)) && (spectrum.count_size < Spectrum::MAX_CHANNELS))
+    {
+        // Block header: value count and encoding variant
+        uint16_t u16 = (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+        p += 2;
+
+        uint16_t cnt = (u16 >> 4) & 0x0FFF;
+        uint8_t vlen = u16 & 0x0F;
+
+        // Add safety check for unreasonable count values
+        if (cnt > 4096)
+        {
+#ifdef DEC_DEBUG_WARNING
+            Serial.print("Warning: Suspicious count value in spectrum: ");
+            Serial.println(cnt);
+#endif
+            cnt = 0; // Skip this block
+        }
+
+        if (vlen > 5)
+        {
+#ifdef DEC_DEBUG_ERROR
+            Serial.print("Error: Unsupported vlen in decodeCountsV1: ");
+            Serial.println(vlen);
+#endif
+            break;
+        }
+
+        // Single end-of-buffer guard for the whole run
+        if ((size_t)(end - p) < ((size_t)cnt * VLEN_BYTES[vlen]))
+        {
+#ifdef DEC_DEBUG_ERROR
+            Serial.println("Error: Truncated value run in decodeCountsV1");
+#endif
+            break;
+        }
+
+        // Clamp the output to the channel array; if the run does not fit,
+        // decode what fits and stop (matching the old per-value check)
+        uint16_t emit = cnt;
+        if ((spectrum.count_size + emit) > Spectrum::MAX_CHANNELS)
+        {
+            emit = (uint16_t)(Spectrum::MAX_CHANNELS - spectrum.count_size);
+        }
+
+        uint32_t* out = spectrum.counts + spectrum.count_size;
+
+        switch (vlen)
+        {
+            case 0: // Run of zero counts
+                for (uint16_t i = 0; i < emit; i++)
+                {
+                    out[i] = 0;
+                }
+                if (emit > 0)
+                {
+                    last = 0;
+                }
+                break;
+
+            case 1: // Absolute uint8 values
+                for (uint16_t i = 0; i < emit; i++)
+                {
+                    last = *p++;
+                    out[i] = last;
+                }
+                break;
+
+            case 2: // int8 deltas relative to the previous value
+                for (uint16_t i = 0; i < emit; i++)
+                {
+                    last += (int8_t)(*p++);
+                    out[i] = last;
+                }
+                break;
+
+            case 3: // int16 deltas
+                for (uint16_t i = 0; i < emit; i++)
+                {
+                    last += (int16_t)((uint16_t)p[0] | ((uint16_t)p[1] << 8));
+                    p += 2;
+                    out[i] = last;
+                }
+                break;
+
+            case 4: // 3-byte deltas, sign carried by the top byte
+                for (uint16_t i = 0; i < emit; i++)
+                {
+                    int32_t delta = ((int32_t)(int8_t)p[2] << 16) | ((int32_t)p[1] << 8) | (int32_t)p[0];
+                    p += 3;
+                    last += delta;
+                    out[i] = last;
+                }
+                break;
+
+            case 5: // int32 deltas
+                for (uint16_t i = 0; i < emit; i++)
+                {
+                    last += (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                        ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+                    p += 4;
+                    out[i] = last;
+                }
+                break;
+        }
+
+        spectrum.count_size += emit;
+
+        if (emit < cnt)
+        {
+            break; // Channel array full
+        }
+    }
+
+    // Commit the bytes consumed by the raw walk back to the buffer
+    br.setPosition(br.getPosition() + (size_t)(p - start));
+}
+
+void decodeSpectrum(BytesBuffer& br, uint8_t format_version, Spectrum& spectrum)
+{
+    uint32_t perf_start = RadiaCodePerf::enabled() ? RadiaCodePerf::now() : 0;
+
+    // Reject structurally bad frames before touching the Spectrum
+    FrameError frame_error = validateSpectrumFrame(br, format_version);
+    if (frame_error != FRAME_OK)
+    {
+#ifdef DEC_DEBUG_ERROR
+        Serial.print("Error: Rejecting spectrum frame: ");
+        Serial.println(frameErrorName(frame_error));
+#endif
+        return;
+    }
+
+    // Clear the spectrum to start with a clean state
+    spectrum.clear();
+
+    // Read spectrum header with error checking
+    uint32_t duration;
+    if (!br.readUint32(&duration))
+    {
+#ifdef DEC_DEBUG_ERROR
+        Serial.println("Error reading spectrum duration");
+#endif
+        return;
+    }
+
+    float a0, a1, a2;
+    if ((!br.readFloat(&a0)) || (!br.readFloat(&a1)) || (!br.readFloat(&a2)))
+    {
+#ifdef DEC_DEBUG_ERROR
+        Serial.println("Error reading spectrum calibration coefficients");
+#endif
+        return;
+    }
+
+    // Only assign values after we've successfully read them
+    spectrum.duration_sec = duration;
+    spectrum.a0 = a0;
+    spectrum.a1 = a1;
+    spectrum.a2 = a2;
+
+    // Decode counts based on format version
+    if (format_version == 0)
+    {
+        decodeCountsV0(br, spectrum);
+    }
+    else if (format_version == 1)
+    {
+        decodeCountsV1(br, spectrum);
+    }
+    else
+    {
+#ifdef DEC_DEBUG_WARNING
+        Serial.print("Warning: Unsupported spectrum format version: ");
+        Serial.println(format_version);
+#endif
+    }
+
+    // Add a safety check on the count_size
+    if (spectrum.count_size > Spectrum::MAX_CHANNELS)
+    {
+#ifdef DEC_DEBUG_ERROR
+        Serial.println("Error: Spectrum count_size exceeds MAX_CHANNELS!");
+#endif
+        spectrum.count_size = Spectrum::MAX_CHANNELS;
+    }
+
+    if (RadiaCodePerf::enabled())
+    {
+        RadiaCodePerf::record(PERF_DECODE_SPECTRUM, RadiaCodePerf::now() - perf_start);
+    }
+}
+
+// Allocation helpers for the data buffer decoder: take from the pool when
+// one is provided, fall back to heap allocation otherwise
+static RealTimeData* allocRealTimeData(DataItemPool* pool)
+{
+    return (pool != nullptr) ? pool->allocRealTimeData() : new RealTimeData();
+}
+
+static RawData* allocRawData(DataItemPool* pool)
+{
+    return (pool != nullptr) ? pool->allocRawData() : new RawData();
+}
+
+static DoseRateDB* allocDoseRateDB(DataItemPool* pool)
+{
+    return (pool != nullptr) ? pool->allocDoseRateDB() : new DoseRateDB();
+}
+
+static RareData* allocRareData(DataItemPool* pool)
+{
+    return (pool != nullptr) ? pool->allocRareData() : new RareData();
+}
+
+static Event* allocEvent(DataItemPool* pool)
+{
+    return (pool != nullptr) ? pool->allocEvent() : new Event();
+}
+
+// Convert a flat record into a heap- or pool-allocated DataItem object.
+// Returns nullptr when the pool is exhausted or the type is unknown.
+static DataItem* materializeRecord(const DataItemRecord& rec, DataItemPool* pool)
+{
+    switch (rec.type)
+    {
+        case TYPE_REAL_TIME_DATA:
+        {
+            RealTimeData* data = allocRealTimeData(pool);
+            if (data == nullptr)
+            {
+                return nullptr;
+            }
+            data->timestamp = rec.timestamp;
+            data->count_rate = rec.real_time.count_rate;
+            data->count_rate_err = rec.real_time.count_rate_err;
+            data->dose_rate = rec.real_time.dose_rate;
+            data->dose_rate_err = rec.real_time.dose_rate_err;
+            data->flags = rec.real_time.flags;
+            data->real_time_flags = rec.real_time.real_time_flags;
+            return data;
+        }
+        case TYPE_RAW_DATA:
+        {
+            RawData* data = allocRawData(pool);
+            if (data == nullptr)
+            {
+                return nullptr;
+            }
+            data->timestamp = rec.timestamp;
+            data->count_rate = rec.raw.count_rate;
+            data->dose_rate = rec.raw.dose_rate;
+            return data;
+        }
+        case TYPE_DOSE_RATE_DB:
+        {
+            DoseRateDB* data = allocDoseRateDB(pool);
+            if (data == nullptr)
+            {
+                return nullptr;
+            }
+            data->timestamp = rec.timestamp;
+            data->count = rec.dose_rate_db.count;
+            data->count_rate = rec.dose_rate_db.count_rate;
+            data->dose_rate = rec.dose_rate_db.dose_rate;
+            data->dose_rate_err = rec.dose_rate_db.dose_rate_err;
+            data->flags = rec.dose_rate_db.flags;
+            return data;
+        }
+        case TYPE_RARE_DATA:
+        {
+            RareData* data = allocRareData(pool);
+            if (data == nullptr)
+            {
+                return nullptr;
+            }
+            data->timestamp = rec.timestamp;
+            data->duration = rec.rare.duration;
+            data->dose = rec.rare.dose;
+            data->temperature = rec.rare.temperature;
+            data->charge_level = rec.rare.charge_level;
+            data->flags = rec.rare.flags;
+            return data;
+        }
+        case TYPE_EVENT:
+        {
+            Event* data = allocEvent(pool);
+            if (data == nullptr)
+            {
+                return nullptr;
+            }
+            data->timestamp = rec.timestamp;
+            data->event = rec.event.event;
+            data->event_param1 = rec.event.event_param1;
+            data->flags = rec.event.flags;
+            return data;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+// Record a decoded item into whichever output the caller provided: a flat
+// record array, a pool, or a vector of heap-allocated items. Returns false
+// when the output capacity is exhausted and decoding should stop.
+static bool emitRecord(const DataItemRecord& rec, DataItemPool* pool, std::vector<DataItem*>* out,
+                       DataItemRecord* records, size_t max_records, size_t* n_records,
+                       AlarmMonitor* monitor)
+{
+    // Inline alarm evaluation: every rate-carrying record is checked here,
+    // during decode, so a threshold crossing fires in the same poll cycle
+    if ((monitor != nullptr) && monitor->enabled())
+    {
+        if (rec.type == TYPE_REAL_TIME_DATA)
+        {
+            monitor->evaluateCountRate(rec.real_time.count_rate, rec.timestamp);
+            monitor->evaluateDoseRate(rec.real_time.dose_rate, rec.timestamp);
+        }
+        else if (rec.type == TYPE_DOSE_RATE_DB)
+        {
+            monitor->evaluateCountRate(rec.dose_rate_db.count_rate, rec.timestamp);
+            monitor->evaluateDoseRate(rec.dose_rate_db.dose_rate, rec.timestamp);
+        }
+    }
+
+    // Flat output path: copy the record, no allocation at all
+    if (records != nullptr)
+    {
+        if (*n_records >= max_records)
+        {
+#ifdef DEC_DEBUG_WARNING
+            Serial.println("Warning: DataItemRecord array full, dropping items");
+#endif
+            return false;
+        }
+        records[(*n_records)++] = rec;
+        return true;
+    }
+
+    // Object output path: pool- or heap-allocated DataItem
+    DataItem* item = materializeRecord(rec, pool);
+    if (item == nullptr)
+    {
+        return false; // Pool exhausted
+    }
+
+    if (out != nullptr)
+    {
+        out->push_back(item);
+    }
+    return true;
+}
+
+// Shared decode loop for all three output representations
+static void decodeDataBufInternal(BytesBuffer& br, uint32_t base_time_sec, DataItemPool* pool,
+                                  std::vector<DataItem*>* out, DataItemRecord* records,
+                                  size_t max_records, size_t* n_records, AlarmMonitor* monitor)
+{
+    uint32_t perf_start = RadiaCodePerf::enabled() ? RadiaCodePerf::now() : 0;
+
+    // Reject structurally bad frames before any decode or allocation
+    FrameError frame_error = validateDataBufFrame(br);
+    if (frame_error != FRAME_OK)
+    {
+#ifdef DEC_DEBUG_ERROR
+        Serial.print("Error: Rejecting data buffer frame: ");
+        Serial.println(frameErrorName(frame_error));
+#endif
+        return;
+    }
+
+    uint8_t next_seq = 0; // Initialize to invalid value
+    bool first_packet = true;
+
+    while (br.available() >= 7)
+    {
+        uint8_t seq, eid, gid;
+        int32_t ts_offset;
+
+        br.readUint8(&seq);
+        br.readUint8(&eid);
+        br.readUint8(&gid);
+        br.readInt32(&ts_offset);
+
+        // Calculate timestamp
+        uint32_t timestamp = base_time_sec + (ts_offset * 10) / 1000;
+
+        // Check sequence number
+        if (!first_packet && (next_seq != seq))
+        {
+            // Only print sequence jump message occasionally to reduce spam
+            static uint32_t last_seq_warning = 0;
+            if ((millis() - last_seq_warning) > 10000) // Every 10 seconds max
+            {
+#ifdef DEC_DEBUG_ERROR
+                Serial.print("Error: Sequence jump detected, expected: ");
+                Serial.print(next_seq);
+                Serial.print(", got: ");
+                Serial.println(seq);
+#endif
+                last_seq_warning = millis();
+            }
+            // Continue processing instead of breaking - sequence jumps are not critical
+            next_seq = seq; // Resync to current sequence
+        }
+        first_packet = false;
+        next_seq = (seq + 1) % 256;
+
+        if ((eid == 0) && (gid == 0)) // GRP_RealTimeData
+        {
+            DataItemRecord rec;
+            rec.type = TYPE_REAL_TIME_DATA;
+            rec.timestamp = timestamp;
+
+            br.readFloat(&rec.real_time.count_rate);
+            // dose_rate should be read as float, not uint16_t
+            br.readFloat(&rec.real_time.dose_rate);  // Read as float directly, no conversion needed
+
+            // count_rate_err and dose_rate_err arrive as raw tenths
+            uint16_t tempCountRateErr, tempDoseRateErr;
+            br.readUint16(&tempCountRateErr);
+            br.readUint16(&tempDoseRateErr);
+            rec.real_time.count_rate_err = tempCountRateErr / 10.0f;
+            rec.real_time.dose_rate_err = tempDoseRateErr / 10.0f;
+
+            br.readUint16(&rec.real_time.flags);
+            br.readUint8(&rec.real_time.real_time_flags);
+
+            if (!emitRecord(rec, pool, out, records, max_records, n_records, monitor))
+            {
+                break; // Output capacity exhausted
+            }
+        }
+        else if ((eid == 0) && (gid == 1)) // GRP_RawData
+        {
+            DataItemRecord rec;
+            rec.type = TYPE_RAW_DATA;
+            rec.timestamp = timestamp;
+
+            br.readFloat(&rec.raw.count_rate);
+            br.readFloat(&rec.raw.dose_rate);
+
+            if (!emitRecord(rec, pool, out, records, max_records, n_records, monitor))
+            {
+                break; // Output capacity exhausted
+            }
+        }
+        else if ((eid == 0) && (gid == 2)) // GRP_DoseRateDB
+        {
+            DataItemRecord rec;
+            rec.type = TYPE_DOSE_RATE_DB;
+            rec.timestamp = timestamp;
+
+            br.readUint32(&rec.dose_rate_db.count);
+            br.readFloat(&rec.dose_rate_db.count_rate);
+            br.readFloat(&rec.dose_rate_db.dose_rate);
+
+            // dose_rate_err arrives as raw tenths
+            uint16_t tempDoseRateErr;
+            br.readUint16(&tempDoseRateErr);
+            rec.dose_rate_db.dose_rate_err = tempDoseRateErr / 10.0f;
+
+            br.readUint16(&rec.dose_rate_db.flags);
+
+            if (!emitRecord(rec, pool, out, records, max_records, n_records, monitor))
+            {
+                break; // Output capacity exhausted
+            }
+        }
+        else if ((eid == 0) && (gid == 3)) // GRP_RareData
+        {
+            DataItemRecord rec;
+            rec.type = TYPE_RARE_DATA;
+            rec.timestamp = timestamp;
+
+            br.readUint32(&rec.rare.duration);
+            br.readFloat(&rec.rare.dose);
+
+            uint16_t temperature, charge_level;
+            br.readUint16(&temperature);
+            br.readUint16(&charge_level);
+            br.readUint16(&rec.rare.flags);
+
+            // Convert raw values to actual values
+            rec.rare.temperature = (temperature - 2000) / 100.0f;
+            rec.rare.charge_level = charge_level / 100.0f;
+
+            if (!emitRecord(rec, pool, out, records, max_records, n_records, monitor))
+            {
+                break; // Output capacity exhausted
+            }
+        }
+        else if ((eid == 0) && (gid == 7)) // GRP_Event
+        {
+            DataItemRecord rec;
+            rec.type = TYPE_EVENT;
+            rec.timestamp = timestamp;
+
+            uint8_t event_id;
+            br.readUint8(&event_id);
+            rec.event.event = static_cast<EventId>(event_id);
+
+            br.readUint8(&rec.event.event_param1);
+            br.readUint16(&rec.event.flags);
+
+            if (!emitRecord(rec, pool, out, records, max_records, n_records, monitor))
+            {
+                break; // Output capacity exhausted
+            }
+        }
+        else if ((eid == 0) && (gid == 9)) // GRP_RawDoseRate - might contain dose rate data
+        {
+            // Store the dose rate as a raw data record
+            DataItemRecord rec;
+            rec.type = TYPE_RAW_DATA;
+            rec.timestamp = timestamp;
+
+            float dose_rate;
+            uint16_t flags;
+            br.readFloat(&dose_rate);
+            br.readUint16(&flags);
+
+            // Set count_rate to 0 since this packet only contains dose_rate
+            rec.raw.count_rate = 0.0f;
+            rec.raw.dose_rate = dose_rate;
+
+#ifdef DEC_DEBUG_INFO
+            // Debug: Print when we find dose rate data
+            Serial.print("Found RawDoseRate: ");
+            Serial.print(dose_rate);
+            Serial.println(" µR/h");
+#endif
+
+            if (!emitRecord(rec, pool, out, records, max_records, n_records, monitor))
+            {
+                break; // Output capacity exhausted
+            }
+        }
+        else
+        {
+            // Skip unknown data types - read and discard based on known patterns
+            if ((eid == 0) && (gid == 4)) // GRP_UserData
+            {
+                uint32_t count;
+                float count_rate, dose_rate;
+                uint16_t dose_rate_err, flags;
+                br.readUint32(&count);
+                br.readFloat(&count_rate);
+                br.readFloat(&dose_rate);
+                br.readUint16(&dose_rate_err);
+                br.readUint16(&flags);
+            }
+            else if ((eid == 0) && (gid == 5)) // GRP_ScheduleData
+            {
+                uint32_t count;
+                float count_rate, dose_rate;
+                uint16_t dose_rate_err, flags;
+                br.readUint32(&count);
+                br.readFloat(&count_rate);
+                br.readFloat(&dose_rate);
+                br.readUint16(&dose_rate_err);
+                br.readUint16(&flags);
+            }
+            else if ((eid == 0) && (gid == 6)) // GRP_AccelData
+            {
+                uint16_t acc_x, acc_y, acc_z;
+                br.readUint16(&acc_x);
+                br.readUint16(&acc_y);
+                br.readUint16(&acc_z);
+            }
+            else if ((eid == 0) && (gid == 8)) // GRP_RawCountRate
+            {
+                float count_rate;
+                uint16_t flags;
+                br.readFloat(&count_rate);
+                br.readUint16(&flags);
+            }
+            else if ((eid == 1) && (gid == 1))
+            {
+                uint16_t samples_num;
+                uint32_t smpl_time_ms;
+                br.readUint16(&samples_num);
+                br.readUint32(&smpl_time_ms);
+
+                // Skip 8 bytes per sample
+                br.setPosition(br.getPosition() + 8 * samples_num);
+            }
+            else if ((eid == 1) && (gid == 2))
+            {
+                uint16_t samples_num;
+                uint32_t smpl_time_ms;
+                br.readUint16(&samples_num);
+                br.readUint32(&smpl_time_ms);
+
+                // Skip 16 bytes per sample
+                br.setPosition(br.getPosition() + 16 * samples_num);
+            }
+            else if ((eid == 1) && (gid == 3))
+            {
+                uint16_t samples_num;
+                uint32_t smpl_time_ms;
+                br.readUint16(&samples_num);
+                br.readUint32(&smpl_time_ms);
+
+                // Skip 14 bytes per sample
+                br.setPosition(br.getPosition() + 14 * samples_num);
+            }
+            else
+            {
+#ifdef DEC_DEBUG_WARNING
+                Serial.print("Warning: Unknown data type: eid=");
+                Serial.print(eid);
+                Serial.print(", gid=");
+                Serial.println(gid);
+#endif
+                break; // Stop processing on unknown data type
+            }
+        }
+    }
+
+    if (RadiaCodePerf::enabled())
+    {
+        RadiaCodePerf::record(PERF_DECODE_DATABUF, RadiaCodePerf::now() - perf_start);
+    }
+}
+
+std::vector<DataItem*> decodeDataBuf(BytesBuffer& br, uint32_t base_time_sec, AlarmMonitor* monitor)
+{
+    std::vector<DataItem*> ret;
+    decodeDataBufInternal(br, base_time_sec, nullptr, &ret, nullptr, 0, nullptr, monitor);
+    return ret;
+}
+
+size_t decodeDataBuf(BytesBuffer& br, uint32_t base_time_sec, DataItemPool& pool, AlarmMonitor* monitor)
+{
+    // Per-poll lifetime: everything from the previous poll is released here
+    pool.reset();
+    decodeDataBufInternal(br, base_time_sec, &pool, nullptr, nullptr, 0, nullptr, monitor);
+    return pool.used();
+}
+
+size_t decodeDataBuf(BytesBuffer& br, uint32_t base_time_sec, DataItemRecord* records, size_t max_records, AlarmMonitor* monitor)
+{
+    if ((records == nullptr) || (max_records == 0))
+    {
+#ifdef DEC_DEBUG_ERROR
+        Serial.println("Error: No record array provided to decodeDataBuf");
+#endif
+        return 0;
+    }
+
+    size_t n_records = 0;
+    decodeDataBufInternal(br, base_time_sec, nullptr, nullptr, records, max_records, &n_records, monitor);
+    return n_records;
+}
+
+SpectrumStreamDecoder::SpectrumStreamDecoder(void)
+{
+    _state = ST_IDLE;
+    _format_version = 0;
+    _spectrum = nullptr;
+    _pending_len = 0;
+    _payload_len = 0;
+    _payload_consumed = 0;
+    _last = 0;
+    _run_remaining = 0;
+    _vlen = 0;
+}
+
+void SpectrumStreamDecoder::begin(uint8_t format_version, Spectrum* spectrum)
+{
+    if (spectrum == nullptr)
+    {
+        _state = ST_IDLE;
+        return;
+    }
+
+    _format_version = format_version;
+    _spectrum = spectrum;
+    _spectrum->clear();
+    _pending_len = 0;
+    _payload_len = 0;
+    _payload_consumed = 0;
+    _last = 0;
+    _run_remaining = 0;
+    _vlen = 0;
+    _state = ST_PREAMBLE;
+}
+
+bool SpectrumStreamDecoder::complete(void) const
+{
+    return _state == ST_DONE;
+}
+
+bool SpectrumStreamDecoder::failed(void) const
+{
+    return _state == ST_FAILED;
+}
+
+void SpectrumStreamDecoder::feedThunk(void* ctx, const uint8_t* data, size_t length)
+{
+    if (ctx != nullptr)
+    {
+        ((SpectrumStreamDecoder*)ctx)->feed(data, length);
+    }
+}
+
+void SpectrumStreamDecoder::feed(const uint8_t* data, size_t length)
+{
+    if ((data == nullptr) || (_spectrum == nullptr))
+    {
+        return;
+    }
+
+    size_t pos = 0;
+    while (pos < length)
+    {
+        if ((_state == ST_PREAMBLE) || (_state == ST_SPEC_HEADER))
+        {
+            // Both fixed-layout sections are 16 bytes; accumulate across
+            // fragments until the section is complete
+            size_t take = 16 - _pending_len;
+            if (take > (length - pos))
+            {
+                take = length - pos;
+            }
+            memcpy(_pending + _pending_len, data + pos, take);
+            _pending_len += take;
+            pos += take;
+
+            if (_pending_len < 16)
+            {
+                return; // Section continues in the next fragment
+            }
+            _pending_len = 0;
+
+            if (_state == ST_PREAMBLE)
+            {
+                // Length prefix (0..3) and response header (4..7) are
+                // checked by the regular path; here only the read response
+                // fields matter: retcode (8..11) and payload length (12..15)
+                uint32_t retcode = (uint32_t)_pending[8] | ((uint32_t)_pending[9] << 8) |
+                    ((uint32_t)_pending[10] << 16) | ((uint32_t)_pending[11] << 24);
+                uint32_t flen = (uint32_t)_pending[12] | ((uint32_t)_pending[13] << 8) |
+                    ((uint32_t)_pending[14] << 16) | ((uint32_t)_pending[15] << 24);
+
+                if ((retcode != 1) || (flen < 16))
+                {
+#ifdef DEC_DEBUG_ERROR
+                    Serial.print("Error: Bad spectrum stream preamble, retcode=");
+                    Serial.print(retcode);
+                    Serial.print(" len=");
+                    Serial.println(flen);
+#endif
+                    _state = ST_FAILED;
+                    return;
+                }
+
+                _payload_len = flen;
+                _state = ST_SPEC_HEADER;
+            }
+            else
+            {
+                // Spectrum header: duration then the three calibration
+                // coefficients
+                uint32_t duration = (uint32_t)_pending[0] | ((uint32_t)_pending[1] << 8) |
+                    ((uint32_t)_pending[2] << 16) | ((uint32_t)_pending[3] << 24);
+                _spectrum->duration_sec = duration;
+                memcpy(&_spectrum->a0, _pending + 4, 4);
+                memcpy(&_spectrum->a1, _pending + 8, 4);
+                memcpy(&_spectrum->a2, _pending + 12, 4);
+
+                _payload_consumed = 16;
+                _last = 0;
+                _run_remaining = 0;
+                _state = ST_COUNTS;
+            }
+        }
+        else if (_state == ST_COUNTS)
+        {
+            // Feed count bytes up to the announced payload length; anything
+            // beyond it (e.g. the firmware's stray trailing byte) is ignored
+            size_t take = length - pos;
+            size_t payload_left = _payload_len - _payload_consumed;
+            if (take > payload_left)
+            {
+                take = payload_left;
+            }
+
+            if (_format_version == 0)
+            {
+                feedCountsV0(data + pos, take);
+            }
+            else if (_format_version == 1)
+            {
+                feedCountsV1(data + pos, take);
+            }
+            else
+            {
+#ifdef DEC_DEBUG_WARNING
+                Serial.print("Warning: Unsupported spectrum format version: ");
+                Serial.println(_format_version);
+#endif
+                _state = ST_FAILED;
+                return;
+            }
+
+            if (_state == ST_FAILED)
+            {
+                return;
+            }
+
+            _payload_consumed += take;
+            pos += take;
+
+            if (_payload_consumed >= _payload_len)
+            {
+                _state = ST_DONE;
+                return;
+            }
+        }
+        else
+        {
+            return; // Idle, done or failed: nothing to consume
+        }
+    }
+}
+
+void SpectrumStreamDecoder::emitValue(uint32_t value)
+{
+    if (_spectrum->count_size < Spectrum::MAX_CHANNELS)
+    {
+        _spectrum->counts[_spectrum->count_size++] = value;
+    }
+}
+
+void SpectrumStreamDecoder::feedCountsV0(const uint8_t* data, size_t length)
+{
+    size_t pos = 0;
+
+    // Complete a uint32 left over from the previous fragment
+    while ((_pending_len > 0) && (_pending_len < 4) && (pos < length))
+    {
+        _pending[_pending_len++] = data[pos++];
+    }
+    if (_pending_len == 4)
+    {
+        emitValue((uint32_t)_pending[0] | ((uint32_t)_pending[1] << 8) |
+            ((uint32_t)_pending[2] << 16) | ((uint32_t)_pending[3] << 24));
+        _pending_len = 0;
+    }
+
+    // Whole values straight from the fragment
+    while ((length - pos) >= 4)
+    {
+        emitValue((uint32_t)data[pos] | ((uint32_t)data[pos + 1] << 8) |
+            ((uint32_t)data[pos + 2] << 16) | ((uint32_t)data[pos + 3] << 24));
+        pos += 4;
+    }
+
+    // Stash a trailing partial value for the next fragment
+    while (pos < length)
+    {
+        _pending[_pending_len++] = data[pos++];
+    }
+}
+
+void SpectrumStreamDecoder::feedCountsV1(const uint8_t* data, size_t length)
+{
+    // Encoded bytes per value for each vlen variant
+    static const uint8_t VLEN_BYTES[6] = {0, 1, 1, 2, 3, 4};
+
+    size_t pos = 0;
+    while (pos < length)
+    {
+        if (_run_remaining == 0)
+        {
+            // Assemble the 2-byte block header, possibly across fragments
+            while ((_pending_len < 2) && (pos < length))
+            {
+                _pending[_pending_len++] = data[pos++];
+            }
+            if (_pending_len < 2)
+            {
+                return;
+            }
+            _pending_len = 0;
+
+            uint16_t u16 = (uint16_t)_pending[0] | ((uint16_t)_pending[1] << 8);
+            uint16_t cnt = (u16 >> 4) & 0x0FFF;
+            uint8_t vlen = u16 & 0x0F;
+
+            if (vlen > 5)
+            {
+#ifdef DEC_DEBUG_ERROR
+                Serial.print("Error: Unsupported vlen in spectrum stream: ");
+                Serial.println(vlen);
+#endif
+                _state = ST_FAILED;
+                return;
+            }
+
+            if (cnt > 4096)
+            {
+#ifdef DEC_DEBUG_WARNING
+                Serial.print("Warning: Suspicious count value in spectrum: ");
+                Serial.println(cnt);
+#endif
+                cnt = 0; // Skip this block
+            }
+
+            if (vlen == 0)
+            {
+                // A zero run carries no value bytes; emit it right away
+                for (uint16_t i = 0; i < cnt; i++)
+                {
+                    emitValue(0);
+                }
+                if (cnt > 0)
+                {
+                    _last = 0;
+                }
+                continue;
+            }
+
+            _vlen = vlen;
+            _run_remaining = cnt;
+        }
+
+        size_t vbytes = VLEN_BYTES[_vlen];
+
+        // Complete a value left over from the previous fragment
+        if (_pending_len > 0)
+        {
+            while ((_pending_len < vbytes) && (pos < length))
+            {
+                _pending[_pending_len++] = data[pos++];
+            }
+            if (_pending_len < vbytes)
+            {
+                return;
+            }
+            _pending_len = 0;
+
+            const uint8_t* v = _pending;
+            switch (_vlen)
+            {
+                case 1: _last = v[0]; break;
+                case 2: _last += (int8_t)v[0]; break;
+                case 3: _last += (int16_t)((uint16_t)v[0] | ((uint16_t)v[1] << 8)); break;
+                case 4: _last += ((int32_t)(int8_t)v[2] << 16) | ((int32_t)v[1] << 8) | (int32_t)v[0]; break;
+                case 5: _last += (int32_t)((uint32_t)v[0] | ((uint32_t)v[1] << 8) |
+                            ((uint32_t)v[2] << 16) | ((uint32_t)v[3] << 24)); break;
+            }
+            emitValue(_last);
+            _run_remaining--;
+            continue;
+        }
+
+        // Whole values straight from the fragment, one tight loop per run
+        size_t whole = (length - pos) / vbytes;
+        if (whole > _run_remaining)
+        {
+            whole = _run_remaining;
+        }
+
+        const uint8_t* p = data + pos;
+        switch (_vlen)
+        {
+            case 1:
+                for (size_t i = 0; i < whole; i++)
+                {
+                    _last = *p++;
+                    emitValue(_last);
+                }
+                break;
+
+            case 2:
+                for (size_t i = 0; i < whole; i++)
+                {
+                    _last += (int8_t)(*p++);
+                    emitValue(_last);
+                }
+                break;
+
+            case 3:
+                for (size_t i = 0; i < whole; i++)
+                {
+                    _last += (int16_t)((uint16_t)p[0] | ((uint16_t)p[1] << 8));
+                    p += 2;
+                    emitValue(_last);
+                }
+                break;
+
+            case 4:
+                for (size_t i = 0; i < whole; i++)
+                {
+                    _last += ((int32_t)(int8_t)p[2] << 16) | ((int32_t)p[1] << 8) | (int32_t)p[0];
+                    p += 3;
+                    emitValue(_last);
+                }
+                break;
+
+            case 5:
+                for (size_t i = 0; i < whole; i++)
+                {
+                    _last += (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                        ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+                    p += 4;
+                    emitValue(_last);
+                }
+                break;
+        }
+
+        pos += whole * vbytes;
+        _run_remaining -= (uint16_t)whole;
+
+        // Stash a trailing partial value for the next fragment
+        if ((_run_remaining > 0) && (pos < length))
+        {
+            while (pos < length)
+            {
+                _pending[_pending_len++] = data[pos++];
+            }
+        }
+    }
+}
@@ -27,10 +27,109 @@
 #include "BytesBuffer.h"
 #include <vector>
 
-// Decode data buffer from device
-std::vector<DataItem*> decodeDataBuf(BytesBuffer& br, uint32_t base_time_sec);
+// Structural verdict on a raw response frame, produced by the validators
+// below before any decode work starts
+enum FrameError
+{
+    FRAME_OK = 0,
+    FRAME_TOO_SHORT,   // Not enough bytes for the fixed header
+    FRAME_BAD_FORMAT,  // Unsupported spectrum format version
+    FRAME_BAD_HEADER,  // Malformed block header inside the payload
+    FRAME_TRUNCATED    // A run or group extends past the end of the frame
+};
+
+// Human-readable name for a FrameError, for diagnostics
+const char* frameErrorName(FrameError error);
+
+// Cheap structural checks over a raw response, without consuming it:
+// length consistency of every run or group against the frame end, header
+// sanity, format version. A corrupted frame - common on marginal BLE
+// links - is rejected in microseconds, before the decoders clear the
+// Spectrum, allocate DataItems or burn CPU partially decoding it. An
+// unknown group id in a data buffer is not corruption, only the end of
+// the validatable prefix (the decoders stop there on their own); the
+// checks reject genuinely inconsistent structure. The decode entry
+// points call these themselves; they are exposed for callers that want
+// the typed verdict.
+FrameError validateSpectrumFrame(const BytesBuffer& br, uint8_t format_version);
+FrameError validateDataBufFrame(const BytesBuffer& br);
+
+// Decode data buffer from device. If an AlarmMonitor with configured
+// thresholds is passed, every decoded RealTimeData/DoseRateDB record is
+// evaluated against it inline - no extra pass over the data, so threshold
+// crossings fire within the same poll cycle.
+std::vector<DataItem*> decodeDataBuf(BytesBuffer& br, uint32_t base_time_sec, AlarmMonitor* monitor = nullptr);
+
+// Decode data buffer into a fixed-capacity pool (zero heap allocations).
+// The pool is reset first, so items from the previous poll are released.
+// Returns the number of items decoded.
+size_t decodeDataBuf(BytesBuffer& br, uint32_t base_time_sec, DataItemPool& pool, AlarmMonitor* monitor = nullptr);
+
+// Decode data buffer into a caller-provided flat array of tagged-union
+// records - no allocation, no pointer indirection. Returns the number of
+// records written (at most max_records).
+size_t decodeDataBuf(BytesBuffer& br, uint32_t base_time_sec, DataItemRecord* records, size_t max_records, AlarmMonitor* monitor = nullptr);
 
 // Decode spectrum data directly into an existing Spectrum object
 void decodeSpectrum(BytesBuffer& br, uint8_t format_version, Spectrum& spectrum);
 
+// Incremental spectrum decoder: feed() consumes raw response fragments
+// (length prefix and headers included) as the transport receives them and
+// decodes straight into the target Spectrum, so decode time overlaps the
+// transfer instead of following it. Runs and multi-byte values that span
+// fragment boundaries are carried over internally. If the stream turns out
+// to be malformed the decoder flags failure and the caller falls back to
+// the buffered decodeSpectrum() path.
+class SpectrumStreamDecoder
+{
+    public:
+        SpectrumStreamDecoder(void);
+
+        // Arm the decoder for one response. The Spectrum is written in
+        // place while fragments arrive, so it must stay alive (and untouched
+        // by the caller) until complete() or the next begin().
+        void begin(uint8_t format_version, Spectrum* spectrum);
+        // Consume one received fragment
+        void feed(const uint8_t* data, size_t length);
+        // True once the whole payload has been decoded
+        bool complete(void) const;
+        // True if the stream was malformed or the device reported an error
+        bool failed(void) const;
+
+        // Trampoline matching RadiaCodeTransport::FragmentCallback
+        static void feedThunk(void* ctx, const uint8_t* data, size_t length);
+
+    private:
+        enum State
+        {
+            ST_IDLE,
+            ST_PREAMBLE,    // Length prefix, response header, retcode, flen
+            ST_SPEC_HEADER, // Duration and calibration coefficients
+            ST_COUNTS,      // Channel data (V0 or V1 encoding)
+            ST_DONE,
+            ST_FAILED
+        };
+
+        void feedCountsV0(const uint8_t* data, size_t length);
+        void feedCountsV1(const uint8_t* data, size_t length);
+        void emitValue(uint32_t value);
+
+        State _state;
+        uint8_t _format_version;
+        Spectrum* _spectrum;
+
+        // Accumulator for fixed-size units that straddle a fragment boundary
+        uint8_t _pending[16];
+        size_t _pending_len;
+
+        // Payload bookkeeping from the response preamble
+        size_t _payload_len;
+        size_t _payload_consumed;
+
+        // V1 run state carried between fragments
+        uint32_t _last;
+        uint16_t _run_remaining;
+        uint8_t _vlen;
+};
+
 #endif
@@ -1,1226 +1,2646 @@
-/**********************************************************************************/
-/* Copyright (c) 2025 Markus Geiger                                               */
-/*                                                                                */
-/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
-/* of this software and associated documentation files (the "Software"), to deal  */
-/* in the Software without restriction, including without limitation the rights   */
-/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
-/* copies of the Software, and to permit persons to whom the Software is          */
-/* furnished to do so, subject to the following conditions:                       */
-/*                                                                                */
-/* The above copyright notice and this permission notice shall be included in all */
-/* copies or substantial portions of the Software.                                */
-/*                                                                                */
-/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
-/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
-/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
-/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
-/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
-/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
-/* SOFTWARE.                                                                      */
-/**********************************************************************************/
-
-/*
-  RadiaCode.cpp - Library implementation for interfacing with RadiaCode radiation detection devices
-*/
-
-#include "RadiaCode.h"
-#include "BluetoothTransport.h"
-#include "Decoders.h"
-#include <time.h>
-
-// Debugging switches
-#undef  RC_DEBUG_INFO
-#define RC_DEBUG_WARNING
-#define RC_DEBUG_ERROR
-
-float spectrumChannelToEnergy(int channel_number, float a0, float a1, float a2)
-{
-    return a0 + a1 * channel_number + a2 * channel_number * channel_number;
-}
-
-const char* getDriverVersion(void)
-{
-    static char version[16];
-    snprintf(version, sizeof(version), "%d.%d.%d", DRIVER_VERSION_MAJOR, DRIVER_VERSION_MINOR, DRIVER_VERSION_PATCH);
-    return version;
-}
-
-RadiaCode::RadiaCode(const char* bluetooth_mac, bool ignore_firmware_compatibility_check)
-{
-    _seq = 0;
-    _connection = nullptr;
-    _base_time_sec = 0;
-    _spectrum_format_version = 0;
-
-    // Check if bluetooth is supported on this platform
-#if defined(ARDUINO_ARCH_ESP32)
-    _bt_supported = true;
-#else
-    _bt_supported = false;
-#endif
-
-    // Connect via Bluetooth
-    try
-    {
-        if (bluetooth_mac != nullptr && _bt_supported)
-        {
-#if defined(ARDUINO_ARCH_ESP32)
-            _connection = new BluetoothTransport(bluetooth_mac);
-#endif
-        }
-
-        if (_connection == nullptr)
-        {
-#ifdef RC_DEBUG_ERROR
-            Serial.println("Error: Failed to create transport connection");
-#endif
-            return;
-        }
-
-        // Initialize device with error handling
-        uint8_t init_data[] = {0x01, 0xFF, 0x12, 0xFF};
-        execute(COMMAND::SET_EXCHANGE, init_data, sizeof(init_data));
-
-        // Set current time
-        time_t now = time(nullptr);   // Get current time in UNIX format, years since 1900
-        if (now > 0)
-        {
-            struct tm* timeinfo = localtime(&now);
-            if (timeinfo != nullptr)
-            {
-                setLocalTime(timeinfo->tm_mday, timeinfo->tm_mon + 1, timeinfo->tm_year + 1900, 
-                    timeinfo->tm_sec, timeinfo->tm_min, timeinfo->tm_hour);
-            }
-            // Calculate base time (current time + 128 seconds)
-            _base_time_sec = now + 128;
-        }
-
-        deviceTime(0);
-
-        // Check firmware version
-        auto version = fwVersion();
-        int vmaj = std::get<3>(version);
-        int vmin = std::get<4>(version);
-
-#ifdef RC_DEBUG_ERROR
-        if (!ignore_firmware_compatibility_check && ((vmaj < 4) || ((vmaj == 4) && (vmin < 8))))
-        {
-            char error_msg[100];
-            sprintf(error_msg, "Error:Incompatible firmware version %d.%d, >=4.8 required. Upgrade device firmware", vmaj, vmin);
-            Serial.println(error_msg);
-        }
-#endif
-
-        // Determine spectrum format version
-        String config = configuration();
-        int pos = config.indexOf("SpecFormatVersion=");
-        if (pos >= 0)
-        {
-            String versionSubstr = config.substring(pos + 18);
-            int newlinePos = versionSubstr.indexOf('\n');
-            if (newlinePos > 0)
-            {
-                versionSubstr = versionSubstr.substring(0, newlinePos);
-            }
-            _spectrum_format_version = versionSubstr.toInt();
-        }
-    }
-    catch (...)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error during RadiaCode initialization");
-#endif
-        if (_connection != nullptr)
-        {
-            delete _connection;
-            _connection = nullptr;
-        }
-    }
-}
-
-RadiaCode::~RadiaCode(void)
-{
-    if (_connection != nullptr)
-    {
-        delete _connection;
-        _connection = nullptr;
-    }
-}
-
-BytesBuffer RadiaCode::execute(COMMAND reqtype, const uint8_t* args, size_t args_len)
-{
-    // Check if connection is valid
-    if (_connection == nullptr)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: Connection is null in execute()");
-#endif
-        return BytesBuffer(); // Return empty buffer
-    }
-
-    uint8_t req_seq_no = 0x80 + _seq;
-    _seq = (_seq + 1) % 32;
-
-    // Create request header
-    uint8_t req_header[4];
-    req_header[0] = (uint8_t)((uint16_t)reqtype & 0xFF);
-    req_header[1] = (uint8_t)(((uint16_t)reqtype >> 8) & 0xFF);
-    req_header[2] = 0;
-    req_header[3] = req_seq_no;
-
-#ifdef RC_DEBUG_INFO
-    // Debug: Print command info
-    Serial.print("CMD 0x");
-    Serial.print((uint16_t)reqtype, HEX);
-    Serial.print(" (");
-    Serial.print((uint16_t)reqtype);
-    Serial.print(") seq=");
-    Serial.print(req_seq_no, HEX);
-    Serial.print(" args_len=");
-    Serial.print(args_len);
-#endif
-
-    // Calculate total request size
-    size_t request_size = sizeof(req_header) + (args_len > 0 ? args_len : 0);
-    uint8_t* request = new uint8_t[request_size];
-
-    // Copy header and args to request buffer
-    memcpy(request, req_header, sizeof(req_header));
-    if (args != nullptr && args_len > 0)
-    {
-        memcpy(request + sizeof(req_header), args, args_len);
-    }
-
-#ifdef RC_DEBUG_INFO
-    // Debug: Print request bytes
-    Serial.print(" TX[");
-    Serial.print(request_size + 4);
-    Serial.print("]: ");
-#endif
-
-    // Create full request with length prefix
-    uint32_t request_len = request_size;
-    uint8_t* full_request = new uint8_t[request_size + 4];
-    memcpy(full_request, &request_len, 4);
-    memcpy(full_request + 4, request, request_size);
-
-#ifdef RC_DEBUG_INFO
-    // Print length prefix and request
-    for (size_t i = 0; i < 4; i++)
-    {
-        if (full_request[i] < 0x10) Serial.print("0");
-        Serial.print(full_request[i], HEX);
-        Serial.print(" ");
-    }
-
-    for (size_t i = 0; i < request_size; i++)
-    {
-        if (request[i] < 0x10) Serial.print("0");
-        Serial.print(request[i], HEX);
-        Serial.print(" ");
-    }
-#endif
-
-    // Execute request
-    BytesBuffer response = _connection->execute(full_request, request_size + 4);
-
-#ifdef RC_DEBUG_INFO
-    // Debug: Print response bytes
-    Serial.print(" RX[");
-    Serial.print(response.getSize());
-    Serial.print("]: ");
-#endif
-
-#ifdef RC_DEBUG_INFO
-    // Print first 128 bytes of response for debugging
-    size_t debug_len = min((size_t)128, response.getSize());
-    uint8_t temp_buf[128];
-    size_t original_pos = response.getPosition();
-    response.setPosition(0);
-    response.readBytes(temp_buf, debug_len);
-    response.setPosition(original_pos);
-
-    for (size_t i = 0; i < debug_len; i++)
-    {
-        if (temp_buf[i] < 0x10) Serial.print("0");
-        Serial.print(temp_buf[i], HEX);
-        Serial.print(" ");
-    }
-    if (response.getSize() > 128)
-    {
-        Serial.print("...");
-    }
-    Serial.println();
-#endif
-
-    // Clean up
-    delete[] request;
-    delete[] full_request;
-
-    // Check response header
-    uint8_t resp_header[4];
-    response.readBytes(resp_header, 4);
-
-#ifdef RC_DEBUG_INFO
-    for (int i = 0; i < 4; i++)
-    {
-        if (req_header[i] != resp_header[i])
-        {
-            Serial.print("Header mismatch: req=");
-            for (int j = 0; j < 4; j++)
-            {
-                Serial.print(req_header[j], HEX);
-            }
-            Serial.print(", resp=");
-            for (int j = 0; j < 4; j++)
-            {
-                Serial.print(resp_header[j], HEX);
-            }
-            Serial.println();
-            break;
-        }
-    }
-#endif
-
-    return response;
-}
-
-BytesBuffer RadiaCode::readRequest(uint32_t command_id)
-{
-#ifdef RC_DEBUG_INFO
-    Serial.print("READ_REQ 0x");
-    Serial.print(command_id, HEX);
-    Serial.print(" (");
-    Serial.print(command_id);
-    Serial.print(")");
-#endif
-
-    uint8_t cmd_bytes[4];
-    memcpy(cmd_bytes, &command_id, 4);
-
-    BytesBuffer r = execute(COMMAND::RD_VIRT_STRING, cmd_bytes, 4);
-
-    // Check if we got a valid response with enough data for header (8 bytes minimum)
-    if (r.getSize() < 8)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.print("Error: Invalid response size for command ");
-        Serial.println(command_id);
-#endif
-        return BytesBuffer(); // Return empty buffer
-    }
-
-    uint32_t retcode = 0;
-    uint32_t flen = 0;
-    bool headerValid = r.readUint32(&retcode) && r.readUint32(&flen);
-
-    if (!headerValid)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: Failed to read response header");
-#endif
-        return BytesBuffer(); // Return empty buffer
-    }
-
-#ifdef RC_DEBUG_INFO
-    Serial.print(" -> retcode=");
-    Serial.print(retcode);
-    Serial.print(" len=");
-    Serial.println(flen);
-#endif
-
-#ifdef RC_DEBUG_ERROR
-    if (retcode != 1)
-    {
-        Serial.print("Error: Unexpected return code for command ");
-        Serial.print(command_id, HEX);
-        Serial.print(": ");
-        Serial.println(retcode);
-        // Continue processing anyway
-    }
-#endif
-
-#ifdef RC_DEBUG_WARNING
-    // Add a safety check for the expected data size
-    if (flen > (BytesBuffer::MAX_BUFFER_SIZE - 8))
-    {
-        Serial.print("Warning: Data length too large in readRequest: ");
-        Serial.println(flen);
-    }
-#endif
-
-    // Workaround for firmware bug (if present)
-    size_t remaining_size = r.available();
-    if (remaining_size == (flen + 1))
-    {
-        uint8_t last_byte;
-        r.peekBytes(&last_byte, remaining_size - 1, 1);
-        if (last_byte == 0x00)
-        {
-            // Truncate last byte
-            r.setSize(r.getPosition() + remaining_size - 1);
-        }
-    }
-
-#ifdef RC_DEBUG_ERROR
-    if (r.available() != flen)
-    {
-        Serial.print("Error: Unexpected data size for command ");
-        Serial.print(command_id, HEX);
-        Serial.print(": expected ");
-        Serial.print(flen);
-        Serial.print(", got ");
-        Serial.println(r.available());
-    }
-#endif
-
-  return r;
-}
-
-void RadiaCode::writeRequest(uint32_t command_id, const uint8_t* data, size_t data_len)
-{
-#ifdef RC_DEBUG_INFO
-    Serial.print("WRITE_REQ 0x");
-    Serial.print(command_id, HEX);
-    Serial.print(" (");
-    Serial.print(command_id);
-    Serial.print(") len=");
-    Serial.print(data_len);
-#endif
-
-    // Create command buffer
-    size_t cmd_size = 4 + (data != nullptr ? data_len : 0);
-    uint8_t* cmd_data = new uint8_t[cmd_size];
-
-    // Add command ID
-    memcpy(cmd_data, &command_id, 4);
-
-    // Add data if present
-    if (data != nullptr && data_len > 0)
-    {
-        memcpy(cmd_data + 4, data, data_len);
-    }
-
-    // Execute command
-    BytesBuffer r = execute(COMMAND::WR_VIRT_SFR, cmd_data, cmd_size);
-
-    // Clean up
-    delete[] cmd_data;
-
-    // Check response
-    uint32_t retcode;
-    r.readUint32(&retcode);
-
-#ifdef RC_DEBUG_INFO
-    Serial.print(" -> retcode=");
-    Serial.println(retcode);
-#endif
-
-#ifdef RC_DEBUG_ERROR
-    if (retcode != 1)
-    {
-        Serial.print("Write request failed, retcode=");
-        Serial.println(retcode);
-    }
-#endif
-}
-
-std::vector<float> RadiaCode::batchReadVSFRs(const std::vector<uint32_t>& vsfr_ids)
-{
-    std::vector<float> ret;
-
-    size_t nvsfr = vsfr_ids.size();
-    if (nvsfr == 0)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: No VSFRs specified");
-#endif
-        return ret;
-    }
-
-    // Prepare message buffer
-    size_t msg_size = 4 + nvsfr * 4; // 4 bytes for count, 4 bytes per VSFR ID
-    uint8_t* msg = new uint8_t[msg_size];
-
-    // Add count
-    uint32_t count = nvsfr;
-    memcpy(msg, &count, 4);
-
-    // Add VSFR IDs
-    for (size_t i = 0; i < nvsfr; i++)
-    {
-        uint32_t vsfr_id = vsfr_ids[i];
-        memcpy(msg + 4 + i * 4, &vsfr_id, 4);
-    }
-
-    // Send request
-    BytesBuffer r = execute(COMMAND::RD_VIRT_SFR_BATCH, msg, msg_size);
-
-    // Clean up
-    delete[] msg;
-
-    // Check validity flags
-    uint32_t valid_flags;
-    r.readUint32(&valid_flags);
-
-    uint32_t expected_flags = (1 << nvsfr) - 1;
-    if (valid_flags != expected_flags)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.print("Error: Unexpected validity flags, bad vsfr_id? ");
-        Serial.print(valid_flags, BIN);
-        Serial.print(" != ");
-        Serial.println(expected_flags, BIN);
-#endif
-        return ret;
-    }
-
-    // Read values
-    for (size_t i = 0; i < nvsfr; i++)
-    {
-        uint32_t raw_value;
-        r.readUint32(&raw_value);
-
-        // Convert to appropriate type based on VSFR format
-        // This is a simplified version as Arduino doesn't easily support complex type handling
-        // In a full implementation, we'd need to map each VSFR to its format
-
-        uint32_t vsfr_id = vsfr_ids[i];
-        if ((vsfr_id == VSFR::CHN_TO_keV_A0) || (vsfr_id == VSFR::CHN_TO_keV_A1) || (vsfr_id == VSFR::CHN_TO_keV_A2))
-        {
-            // These are float values
-            float float_val;
-            memcpy(&float_val, &raw_value, 4);
-            ret.push_back(float_val);
-        }
-        else if ((vsfr_id == VSFR::DS_UNITS) || (vsfr_id == VSFR::CR_UNITS))
-        {
-            // These are boolean flags in the LSB
-            ret.push_back(raw_value & 0x01);
-        }
-        else if ((vsfr_id == VSFR::TEMP_degC) || (vsfr_id == VSFR::RAW_TEMP_degC) || 
-                 (vsfr_id == VSFR::TEMP_UP_degC) || (vsfr_id == VSFR::TEMP_DN_degC))
-        {
-            // Temperature values - these are IEEE-754 float values
-            float float_val;
-            memcpy(&float_val, &raw_value, 4);
-            ret.push_back(float_val);
-        }
-        else
-        {
-            // Most values are integers
-            ret.push_back((float)raw_value);
-        }
-    }
-
-    return ret;
-}
-
-uint32_t RadiaCode::readVSFR(uint32_t vsfr_id)
-{
-    // Prepare message buffer for single VSFR
-    size_t msg_size = 4 + 4; // 4 bytes for count, 4 bytes for VSFR ID
-    uint8_t* msg = new uint8_t[msg_size];
-
-    // Add count (1 VSFR)
-    uint32_t count = 1;
-    memcpy(msg, &count, 4);
-
-    // Add VSFR ID
-    memcpy(msg + 4, &vsfr_id, 4);
-
-    // Send request
-    BytesBuffer r = execute(COMMAND::RD_VIRT_SFR_BATCH, msg, msg_size);
-
-    // Clean up
-    delete[] msg;
-
-    // Check validity flags
-    uint32_t valid_flags;
-    r.readUint32(&valid_flags);
-
-    if (valid_flags != 1)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.print("Error: Invalid VSFR ID 0x");
-        Serial.print(vsfr_id, HEX);
-        Serial.print(", validity flags: ");
-        Serial.println(valid_flags, BIN);
-#endif
-        return 0;
-    }
-
-    // Read the single value
-    uint32_t raw_value;
-    r.readUint32(&raw_value);
-
-    return raw_value;
-}
-
-float RadiaCode::getTemperature(void)
-{
-    std::vector<uint32_t> vsfr_ids = {VSFR::TEMP_degC};
-    std::vector<float> values = batchReadVSFRs(vsfr_ids);
-    if (values.size() > 0)
-    {
-        return values[0];
-    }
-    return 0.0f;
-}
-
-uint32_t RadiaCode::deviceStatus(void)
-{
-    uint32_t flags;
-    BytesBuffer r;
-
-    r = execute(COMMAND::GET_STATUS);
-    r.readUint32(&flags);
-    return flags;
-}
-
-void RadiaCode::setLocalTime(uint8_t day, uint8_t month, uint16_t year, uint8_t second, uint8_t minute, uint8_t hour)
-{
-    uint8_t d[8];
-    d[0] = day;
-    d[1] = month;
-    if (year >= 2000)
-    {
-        d[2] = year - 2000; // 2-digit year
-    }
-    else
-    {
-        d[2] = year - 1900; // 2-digit year
-    }
-    d[3] = 0;
-    d[4] = second;
-    d[5] = minute;
-    d[6] = hour;
-    d[7] = 0;
-
-    execute(COMMAND::SET_TIME, d, sizeof(d));
-}
-
-String RadiaCode::fwSignature(void)
-{
-    uint32_t signature;
-    char buf[256];
-    BytesBuffer r = execute(COMMAND::FW_SIGNATURE);
-
-    r.readUint32(&signature);
-    String filename = r.readString();
-    String idstring = r.readString();
-    sprintf(buf, "Signature: %08lX, FileName=\"%s\", IdString=\"%s\"", signature, filename.c_str(), idstring.c_str());
-    return String(buf);
-}
-
-std::tuple<int, int, String, int, int, String> RadiaCode::fwVersion(void)
-{
-    BytesBuffer r;
-    uint16_t boot_minor, boot_major, target_minor, target_major;
-    String boot_date, target_date;
-
-    r = execute(COMMAND::GET_VERSION);
-    r.readUint16(&boot_minor);
-    r.readUint16(&boot_major);
-    boot_date = r.readString();
-
-    r.readUint16(&target_minor);
-    r.readUint16(&target_major);
-
-    target_date = r.readString();
-    target_date.remove(target_date.length() - 1);  // Remove trailing null byte
-
-    return std::make_tuple(boot_major, boot_minor, boot_date, target_major, target_minor, target_date);
-}
-
-String RadiaCode::hwSerialNumber(void)
-{
-    uint32_t serial_len;
-    BytesBuffer r = execute(COMMAND::GET_SERIAL);
-
-    r.readUint32(&serial_len);
-
-    if ((serial_len % 4) != 0)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: Serial number length is not a multiple of 4");
-#endif
-        return "";
-    }
-
-    String serial = "";
-    for (uint32_t i = 0; i < (serial_len / 4); i++)
-    {
-        uint32_t group;
-        r.readUint32(&group);
-        char buf[10];
-        sprintf(buf, "%08lX", group);
-        if (i > 0) serial += "-";
-        serial += buf;
-    }
-
-    return serial;
-}
-
-String RadiaCode::configuration(void)
-{
-    String result;
-    BytesBuffer r = readRequest(VS::CONFIGURATION);
-
-    size_t len = r.available();
-    char* buffer = new char[len + 1];
-    r.readBytes((uint8_t*)buffer, len);
-    buffer[len] = '\0';
-    result = String(buffer);
-    delete[] buffer;
-    return result;
-}
-
-String RadiaCode::textMessage(void)
-{
-    BytesBuffer r = readRequest(VS::TEXT_MESSAGE);
-
-    size_t len = r.available();
-    char* buffer = new char[len + 1];
-    r.readBytes((uint8_t*)buffer, len);
-    buffer[len] = '\0';
-
-    String result = String(buffer);
-    delete[] buffer;
-
-    return result;
-}
-
-String RadiaCode::serialNumber(void)
-{
-    String result;
-    size_t len;
-    BytesBuffer r;
-    char* buffer;
-
-    r = readRequest(VS::SERIAL_NUMBER);
-    len = r.available();
-    buffer = new char[len + 1];
-    r.readBytes((uint8_t*)buffer, len);
-    buffer[len] = '\0';
-    result = String(buffer);
-    delete[] buffer;
-    return result;
-}
-
-String RadiaCode::commands(void)
-{
-    BytesBuffer r = readRequest(VS::SFR_FILE);
-
-    size_t len = r.available();
-    char* buffer = new char[len + 1];
-    r.readBytes((uint8_t*)buffer, len);
-    buffer[len] = '\0';
-
-    String result = String(buffer);
-    delete[] buffer;
-
-    return result;
-}
-
-void RadiaCode::deviceTime(uint32_t v)
-{
-    uint8_t data[4];
-    memcpy(data, &v, 4);
-
-    writeRequest(VSFR::DEVICE_TIME, data, 4);
-}
-
-std::vector<DataItem*> RadiaCode::dataBuf(void)
-{
-    BytesBuffer r = readRequest(VS::DATA_BUF);
-    return decodeDataBuf(r, _base_time_sec);
-}
-
-Spectrum RadiaCode::spectrum(void)
-{
-    // Use a static Spectrum object
-    static Spectrum result;
-
-    // Clear the object for reuse
-    result.clear();
-
-    // Get the raw spectrum data
-    BytesBuffer r = readRequest(VS::SPECTRUM);
-
-    // Check if we got valid data back
-    if (r.getSize() < 16)
-    { // Minimum size for header (duration + a0,a1,a2)
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: Invalid or empty spectrum data received");
-#endif
-        return result; // Return empty spectrum
-    }
-
-    // Process the buffer directly into our static object
-    decodeSpectrum(r, _spectrum_format_version, result);
-
-#ifdef RC_DEBUG_WARNING
-    // Safety check - make sure we got some data
-    if (result.count_size == 0)
-    {
-        Serial.println("Warning: No spectrum data points decoded");
-    }
-#endif
-
-    // Return a copy
-    return result;
-}
-
-Spectrum RadiaCode::spectrumAccum(void)
-{
-    // Use a static Spectrum object
-    static Spectrum result;
-
-    // Clear the object for reuse
-    result.clear();
-    
-    // Get the raw spectrum data
-    BytesBuffer r = readRequest(VS::SPEC_ACCUM);
-    
-    // Check if we got valid data back
-    if (r.getSize() < 16)
-    { // Minimum size for header (duration + a0,a1,a2)
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: Invalid or empty accumulated spectrum data received");
-#endif
-        return result; // Return empty spectrum
-    }
-
-    // Process the buffer directly into our static object
-    decodeSpectrum(r, _spectrum_format_version, result);
-
-#ifdef RC_DEBUG_WARNING
-    // Safety check - make sure we got some data
-    if (result.count_size == 0)
-    {
-        Serial.println("Warning: No accumulated spectrum data points decoded");
-    }
-#endif
-
-    // Return a copy
-    return result;
-}
-
-void RadiaCode::doseReset(void)
-{
-    writeRequest(VSFR::DOSE_RESET);
-}
-
-void RadiaCode::spectrumReset(void)
-{
-    uint32_t cmd = VS::SPECTRUM;
-    uint32_t size = 0;
-
-    uint8_t data[8];
-    memcpy(data, &cmd, 4);
-    memcpy(data + 4, &size, 4);
-
-    BytesBuffer r = execute(COMMAND::WR_VIRT_STRING, data, 8);
-
-    uint32_t retcode;
-    r.readUint32(&retcode);
-
-#ifdef RC_DEBUG_ERROR
-    if (retcode != 1)
-    {
-        Serial.print("Spectrum reset failed, retcode=");
-        Serial.println(retcode);
-    }
-#endif
-}
-
-std::vector<float> RadiaCode::energyCalib(void)
-{
-    BytesBuffer r;
-    std::vector<float> coefficients;
-
-    r = readRequest(VS::ENERGY_CALIB);
-    for (int i = 0; i < 3; i++)
-    {
-        float coef;
-        r.readFloat(&coef);
-        coefficients.push_back(coef);
-    }
-
-    return coefficients;
-}
-
-void RadiaCode::setEnergyCalib(float a0, float a1, float a2)
-{
-    uint32_t retcode;
-    BytesBuffer r;
-    uint8_t  pc[12]; // 3 floats * 4 bytes each
-    uint32_t cmd = VS::ENERGY_CALIB;
-    uint32_t size = sizeof(pc);
-    uint8_t  data[8 + sizeof(pc)];
-
-    memcpy(pc, &a0, 4);
-    memcpy(pc + 4, &a1, 4);
-    memcpy(pc + 8, &a2, 4);
-    memcpy(data, &cmd, 4);
-    memcpy(data + 4, &size, 4);
-    memcpy(data + 8, pc, sizeof(pc));
-    r = execute(COMMAND::WR_VIRT_STRING, data, 8 + sizeof(pc));
-    r.readUint32(&retcode);
-
-#ifdef RC_DEBUG_ERROR
-    if (retcode != 1)
-    {
-        Serial.print("Set energy calibration failed, retcode=");
-        Serial.println(retcode);
-    }
-#endif
-}
-
-uint8_t RadiaCode::getSpectrumFormatVersion(void)
-{
-    return _spectrum_format_version;
-}
-
-void RadiaCode::setLanguage(const char* lang)
-{
-    if ((strcmp(lang, "ru") != 0) && (strcmp(lang, "en") != 0))
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: Unsupported language. Use 'ru' or 'en'");
-#endif
-        return;
-    }
-
-    uint32_t value = (strcmp(lang, "en") == 0) ? 1 : 0;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::DEVICE_LANG, data, 4);
-}
-
-void RadiaCode::setDeviceOn(bool on)
-{
-    uint32_t value = on ? 1 : 0;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::DEVICE_ON, data, 4);
-}
-
-void RadiaCode::setSoundOn(bool on)
-{
-    uint32_t value = on ? 1 : 0;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::SOUND_ON, data, 4);
-}
-
-void RadiaCode::setVibroOn(bool on)
-{
-    uint32_t value = on ? 1 : 0;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::VIBRO_ON, data, 4);
-}
-
-void RadiaCode::setLightOn(bool on)
-{
-    uint8_t data[4];
-    uint32_t deviceCtrl = readVSFR(VSFR::DEVICE_CTRL);
-    if (on)
-    {
-        deviceCtrl |= DEV_CTRL::LIGHT;
-    }
-    else
-    {
-        deviceCtrl &= ~DEV_CTRL::LIGHT;
-    }
-    memcpy(data, &deviceCtrl, 4);
-    writeRequest(VSFR::DEVICE_CTRL, data, 4);
-}
-
-void RadiaCode::setDeviceCtrl(DEV_CTRL ctrl_flags)
-{
-    uint8_t data[4];
-    uint32_t value = (ctrl_flags & ~DEV_CTRL::BIT_1) | DEV_CTRL::BIT_5; // Ensure BIT1 is always 0 and BIT5 is always 1
-
-    memcpy(data, &value, 4);
-    writeRequest(VSFR::DEVICE_CTRL, data, 4);
-}
-
-void RadiaCode::setSoundCtrl(CTRL ctrl_flags)
-{
-    uint32_t value = ctrl_flags;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::SOUND_CTRL, data, 4);
-}
-
-void RadiaCode::setVibroCtrl(CTRL ctrl_flags)
-{
-    // Check if CLICKS flag is set, which is not supported for vibro
-    if (ctrl_flags & CTRL::CLICKS)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: CTRL::CLICKS not supported for vibro");
-#endif
-        return;
-    }
-    // Check if CONNECTION flag is set, which is not supported for vibro
-    if (ctrl_flags & CTRL::CONNECTION)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: CTRL::CONNECTION not supported for vibro");
-#endif
-        return;
-    }
-    // Check if POWER flag is set, which is not supported for vibro
-    if (ctrl_flags & CTRL::POWER)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: CTRL::POWER not supported for vibro");
-#endif
-        return;
-    }
-
-    uint32_t value = ctrl_flags;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::VIBRO_CTRL, data, 4);
-}
-
-void RadiaCode::setDisplayOffTime(uint8_t seconds)
-{
-    if ((seconds != 5) && (seconds != 10) && (seconds != 15) && (seconds != 30))
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: Display off time must be 5, 10, 15, or 30 seconds");
-#endif
-        return;
-    }
-
-    uint32_t value = (seconds == 30) ? 3 : ((seconds / 5) - 1);
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::DISP_OFF_TIME, data, 4);
-}
-
-void RadiaCode::setDisplayBrightness(uint8_t brightness)
-{
-    if (brightness > 9)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: Brightness must be between 0 and 9");
-#endif
-        return;
-    }
-
-    uint32_t value = brightness;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::DISP_BRT, data, 4);
-}
-
-void RadiaCode::setDisplayDirection(DisplayDirection direction)
-{
-    uint32_t value = direction;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::DISP_DIR, data, 4);
-}
-
-void RadiaCode::setDisplayCtrl(DISPLAY_CTRL ctrl_flags)
-{
-    uint32_t value = ctrl_flags;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::DISP_CTRL, data, 4);
-}
-
-void RadiaCode::setMeasurementUnit(MeasurementUnits unit)
-{
-    uint32_t value = unit;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::DS_UNITS, data, 4);
-}
-
-void RadiaCode::setCountRateUnit(CountRateUnits unit)
-{
-    uint32_t value = unit;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::CR_UNITS, data, 4);
-}
-
-void RadiaCode::setTemperatureUnit(TemperatureUnits unit)
-{
-    uint32_t value = unit;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::TEMP_UNITS, data, 4);
-}
-
-void RadiaCode::setAlarmSignalMode(AlarmSignalMode mode)
-{
-    uint32_t value = mode;
-    uint8_t data[4];
-    memcpy(data, &value, 4);
-
-    writeRequest(VSFR::ALARM_MODE, data, 4);
-}
-
-AlarmLimits RadiaCode::getAlarmLimits(void)
-{
-    std::vector<uint32_t> regs =
-    {
-        VSFR::CR_LEV1_cp10s,
-        VSFR::CR_LEV2_cp10s,
-        VSFR::DR_LEV1_uR_h,
-        VSFR::DR_LEV2_uR_h,
-        VSFR::DS_LEV1_uR,
-        VSFR::DS_LEV2_uR,
-        VSFR::DS_UNITS,
-        VSFR::CR_UNITS
-    };
-
-    std::vector<float> resp = batchReadVSFRs(regs);
-
-    AlarmLimits limits;
-
-    if (resp.size() >= 8)
-    {
-        float dose_multiplier = resp[6] ? 100.0f : 1.0f;
-        float count_multiplier = resp[7] ? 60.0f : 1.0f;
-
-        limits.l1_count_rate = resp[0] / 10.0f * count_multiplier;
-        limits.l2_count_rate = resp[1] / 10.0f * count_multiplier;
-        limits.l1_dose_rate = resp[2] / dose_multiplier;
-        limits.l2_dose_rate = resp[3] / dose_multiplier;
-        limits.l1_dose = resp[4] / 1.0e6f / dose_multiplier;
-        limits.l2_dose = resp[5] / 1.0e6f / dose_multiplier;
-        limits.dose_unit = resp[6] ? "Sv" : "R";
-        limits.count_unit = resp[7] ? "cpm" : "cps";
-    }
-
-    return limits;
-}
-
-bool RadiaCode::setAlarmLimits(
-    float l1_count_rate, 
-    float l2_count_rate,
-    float l1_dose_rate, 
-    float l2_dose_rate,
-    float l1_dose, 
-    float l2_dose,
-    bool dose_unit_sv, 
-    bool count_unit_cpm)
-{
-    std::vector<uint32_t> which_limits;
-    std::vector<uint32_t> limit_values;
-
-    float dose_multiplier = dose_unit_sv ? 100.0f : 1.0f;
-    float count_multiplier = count_unit_cpm ? 1.0f / 6.0f : 10.0f;
-
-    if (l1_count_rate >= 0.0f)
-    {
-        which_limits.push_back(VSFR::CR_LEV1_cp10s);
-        limit_values.push_back((uint32_t)round(l1_count_rate * count_multiplier));
-    }
-
-    if (l2_count_rate >= 0.0f)
-    {
-        which_limits.push_back(VSFR::CR_LEV2_cp10s);
-        limit_values.push_back((uint32_t)round(l2_count_rate * count_multiplier));
-    }
-
-    if (l1_dose_rate >= 0.0f)
-    {
-        which_limits.push_back(VSFR::DR_LEV1_uR_h);
-        limit_values.push_back((uint32_t)round(l1_dose_rate * dose_multiplier));
-    }
-
-    if (l2_dose_rate >= 0.0f)
-    {
-        which_limits.push_back(VSFR::DR_LEV2_uR_h);
-        limit_values.push_back((uint32_t)round(l2_dose_rate * dose_multiplier));
-    }
-
-    if (l1_dose >= 0.0f)
-    {
-        which_limits.push_back(VSFR::DS_LEV1_uR);
-        limit_values.push_back((uint32_t)round(l1_dose * 1.0e6f * dose_multiplier));
-    }
-
-    if (l2_dose >= 0.0f)
-    {
-        which_limits.push_back(VSFR::DS_LEV2_uR);
-        limit_values.push_back((uint32_t)round(l2_dose * 1.0e6f * dose_multiplier));
-    }
-
-    size_t num_to_set = which_limits.size();
-    if (num_to_set == 0)
-    {
-#ifdef RC_DEBUG_ERROR
-        Serial.println("Error: No limits specified");
-#endif
-        return false;
-    }
-
-    which_limits.push_back(VSFR::DS_UNITS);
-    limit_values.push_back((uint32_t)(dose_unit_sv ? 1 : 0));
-
-    which_limits.push_back(VSFR::CR_UNITS);
-    limit_values.push_back((uint32_t)(count_unit_cpm ? 1 : 0));
-
-    num_to_set = which_limits.size();
-
-    // Create message buffer
-    size_t msg_size = 4 + num_to_set * 4 * 2; // 4 bytes for count, 4 bytes per ID and value
-    uint8_t* msg = new uint8_t[msg_size];
-
-    // Add count
-    uint32_t count = num_to_set;
-    memcpy(msg, &count, 4);
-
-    // Add IDs
-    for (size_t i = 0; i < num_to_set; i++)
-    {
-        uint32_t id = which_limits[i];
-        memcpy(msg + 4 + i * 4, &id, 4);
-    }
-
-    // Add values
-    for (size_t i = 0; i < num_to_set; i++)
-    {
-        uint32_t value = limit_values[i];
-        memcpy(msg + 4 + num_to_set * 4 + i * 4, &value, 4);
-    }
-
-    // Send request
-    BytesBuffer resp = execute(COMMAND::WR_VIRT_SFR_BATCH, msg, msg_size);
-
-    // Clean up
-    delete[] msg;
-
-    // Check response
-    uint32_t result;
-    resp.readUint32(&result);
-
-    uint32_t expected_valid = (1 << num_to_set) - 1;
-    return expected_valid == result;
-}
+/**********************************************************************************/
+/* Copyright (c) 2025 Markus Geiger                                               */
+/*                                                                                */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
+/* of this software and associated documentation files (the "Software"), to deal  */
+/* in the Software without restriction, including without limitation the rights   */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
+/* copies of the Software, and to permit persons to whom the Software is          */
+/* furnished to do so, subject to the following conditions:                       */
+/*                                                                                */
+/* The above copyright notice and this permission notice shall be included in all */
+/* copies or substantial portions of the Software.                                */
+/*                                                                                */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
+/* SOFTWARE.                                                                      */
+/**********************************************************************************/
+
+/*
+  RadiaCode.cpp - Library implementation for interfacing with RadiaCode radiation detection devices
+*/
+
+#include "RadiaCode.h"
+#include "BluetoothTransport.h"
+#include "SerialTransport.h"
+#include "Decoders.h"
+#include "RadiaCodePerf.h"
+#include <time.h>
+
+// Debugging switches
+#undef  RC_DEBUG_INFO
+#define RC_DEBUG_WARNING
+#define RC_DEBUG_ERROR
+
+float spectrumChannelToEnergy(int channel_number, float a0, float a1, float a2)
+{
+    return a0 + a1 * channel_number + a2 * channel_number * channel_number;
+}
+
+const char* getDriverVersion(void)
+{
+    static char version[16];
+    snprintf(version, sizeof(version), "%d.%d.%d", DRIVER_VERSION_MAJOR, DRIVER_VERSION_MINOR, DRIVER_VERSION_PATCH);
+    return version;
+}
+
+RadiaCode::RadiaCode(const char* bluetooth_mac, bool ignore_firmware_compatibility_check)
+{
+    initMembers();
+
+    // Connect via Bluetooth
+    try
+    {
+        // A null MAC is allowed: the transport then reconnects to the last
+        // peer remembered in its NVS fast-reconnect cache
+        if (_bt_supported)
+        {
+#if defined(ARDUINO_ARCH_ESP32)
+            _connection = new BluetoothTransport(bluetooth_mac);
+#endif
+        }
+
+        initDevice(ignore_firmware_compatibility_check);
+    }
+    catch (...)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error during RadiaCode initialization");
+#endif
+        if (_connection != nullptr)
+        {
+            delete _connection;
+            _connection = nullptr;
+        }
+    }
+}
+
+RadiaCode::RadiaCode(Stream& serial, bool ignore_firmware_compatibility_check)
+{
+    initMembers();
+
+    // Connect over the wire; the Stream must already be opened
+    try
+    {
+        _connection = new SerialTransport(serial);
+        initDevice(ignore_firmware_compatibility_check);
+    }
+    catch (...)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error during RadiaCode initialization");
+#endif
+        if (_connection != nullptr)
+        {
+            delete _connection;
+            _connection = nullptr;
+        }
+    }
+}
+
+void RadiaCode::initMembers(void)
+{
+    _seq = 0;
+    _connection = nullptr;
+    _base_time_sec = 0;
+    _spectrum_format_version = 0;
+    _async_pending = false;
+    _async_command_id = 0;
+    memset(_async_req_header, 0, sizeof(_async_req_header));
+    _diff_seeded = false;
+    _accum_seeded = false;
+    _prefetch_front = 0;
+    _prefetch_active = false;
+    _pipelined_databuf_active = false;
+    _txn_active = false;
+    _txn_count = 0;
+    _vsfr_cache_count = 0;
+
+#if defined(ARDUINO_ARCH_ESP32)
+    _stream_ring = nullptr;
+    _stream_scratch = nullptr;
+    _stream_head = 0;
+    _stream_tail = 0;
+    _stream_dropped = 0;
+    _stream_interval_ms = 0;
+    _stream_min_interval_ms = 0;
+    _stream_max_interval_ms = 0;
+    _stream_task = nullptr;
+    _stream_run = false;
+#endif
+
+    // Check if bluetooth is supported on this platform
+#if defined(ARDUINO_ARCH_ESP32)
+    _bt_supported = true;
+#else
+    _bt_supported = false;
+#endif
+}
+
+void RadiaCode::initDevice(bool ignore_firmware_compatibility_check)
+{
+    if (_connection == nullptr)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Failed to create transport connection");
+#endif
+        return;
+    }
+
+    // Initialize device with error handling
+    uint8_t init_data[] = {0x01, 0xFF, 0x12, 0xFF};
+    execute(COMMAND::SET_EXCHANGE, init_data, sizeof(init_data));
+
+    // Set current time
+    time_t now = time(nullptr);   // Get current time in UNIX format, years since 1900
+    if (now > 0)
+    {
+        struct tm* timeinfo = localtime(&now);
+        if (timeinfo != nullptr)
+        {
+            setLocalTime(timeinfo->tm_mday, timeinfo->tm_mon + 1, timeinfo->tm_year + 1900,
+                timeinfo->tm_sec, timeinfo->tm_min, timeinfo->tm_hour);
+        }
+        // Calculate base time (current time + 128 seconds)
+        _base_time_sec = now + 128;
+    }
+
+    deviceTime(0);
+
+    // Check firmware version
+    auto version = fwVersion();
+    int vmaj = std::get<3>(version);
+    int vmin = std::get<4>(version);
+
+#ifdef RC_DEBUG_ERROR
+    if (!ignore_firmware_compatibility_check && ((vmaj < 4) || ((vmaj == 4) && (vmin < 8))))
+    {
+        char error_msg[100];
+        sprintf(error_msg, "Error:Incompatible firmware version %d.%d, >=4.8 required. Upgrade device firmware", vmaj, vmin);
+        Serial.println(error_msg);
+    }
+#endif
+
+    // Determine spectrum format version
+    String config = configuration();
+    int pos = config.indexOf("SpecFormatVersion=");
+    if (pos >= 0)
+    {
+        String versionSubstr = config.substring(pos + 18);
+        int newlinePos = versionSubstr.indexOf('\n');
+        if (newlinePos > 0)
+        {
+            versionSubstr = versionSubstr.substring(0, newlinePos);
+        }
+        _spectrum_format_version = versionSubstr.toInt();
+    }
+}
+
+RadiaCode::~RadiaCode(void)
+{
+    // Shut down the polling and transport service tasks before the
+    // transport they use goes away
+    stopStreaming();
+    stopPipelinedDataBuf();
+
+    if (_connection != nullptr)
+    {
+        delete _connection;
+        _connection = nullptr;
+    }
+}
+
+size_t RadiaCode::buildFrame(COMMAND reqtype, const uint8_t* args, size_t args_len)
+{
+    // Refuse oversized args instead of heap-allocating; every command the
+    // driver issues fits the fixed frame buffer with room to spare
+    if (args_len > MAX_REQUEST_ARGS)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.print("Error: Request args exceed frame buffer, len=");
+        Serial.println(args_len);
+#endif
+        return 0;
+    }
+
+    uint8_t req_seq_no = 0x80 + _seq;
+    _seq = (_seq + 1) % 32;
+
+    // Assemble the frame in place: length prefix, header, args
+    size_t request_size = 4 + (args != nullptr ? args_len : 0);
+    uint32_t request_len = request_size;
+    memcpy(_frame_buffer, &request_len, 4);
+    _frame_buffer[4] = (uint8_t)((uint16_t)reqtype & 0xFF);
+    _frame_buffer[5] = (uint8_t)(((uint16_t)reqtype >> 8) & 0xFF);
+    _frame_buffer[6] = 0;
+    _frame_buffer[7] = req_seq_no;
+    if (args != nullptr && args_len > 0)
+    {
+        memcpy(_frame_buffer + 8, args, args_len);
+    }
+
+    return request_size + 4;
+}
+
+BytesBuffer RadiaCode::execute(COMMAND reqtype, const uint8_t* args, size_t args_len)
+{
+    // Check if connection is valid
+    if (_connection == nullptr)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Connection is null in execute()");
+#endif
+        return BytesBuffer(); // Return empty buffer
+    }
+
+    size_t frame_size = buildFrame(reqtype, args, args_len);
+    if (frame_size == 0)
+    {
+        return BytesBuffer();
+    }
+
+#ifdef RC_DEBUG_INFO
+    // Debug: Print command info
+    Serial.print("CMD 0x");
+    Serial.print((uint16_t)reqtype, HEX);
+    Serial.print(" (");
+    Serial.print((uint16_t)reqtype);
+    Serial.print(") seq=");
+    Serial.print(_frame_buffer[7], HEX);
+    Serial.print(" args_len=");
+    Serial.print(args_len);
+
+    // Debug: Print request bytes (length prefix, header and args)
+    Serial.print(" TX[");
+    Serial.print(frame_size);
+    Serial.print("]: ");
+    for (size_t i = 0; i < frame_size; i++)
+    {
+        if (_frame_buffer[i] < 0x10) Serial.print("0");
+        Serial.print(_frame_buffer[i], HEX);
+        Serial.print(" ");
+    }
+#endif
+
+    // Keep the request header for the response check below; the frame
+    // buffer itself may be reused by nested calls
+    uint8_t req_header[4];
+    memcpy(req_header, _frame_buffer + 4, 4);
+
+    // Execute request, timing the full round trip when collection is on
+    uint32_t perf_start = RadiaCodePerf::enabled() ? RadiaCodePerf::now() : 0;
+    BytesBuffer response = _connection->execute(_frame_buffer, frame_size);
+    if (RadiaCodePerf::enabled())
+    {
+        uint32_t elapsed = RadiaCodePerf::now() - perf_start;
+        RadiaCodePerf::record(PERF_EXECUTE, elapsed);
+        RadiaCodePerf::recordCommand((uint16_t)reqtype, elapsed);
+    }
+
+#ifdef RC_DEBUG_INFO
+    // Debug: Print response bytes
+    Serial.print(" RX[");
+    Serial.print(response.getSize());
+    Serial.print("]: ");
+#endif
+
+#ifdef RC_DEBUG_INFO
+    // Print first 128 bytes of response for debugging
+    size_t debug_len = min((size_t)128, response.getSize());
+    uint8_t temp_buf[128];
+    size_t original_pos = response.getPosition();
+    response.setPosition(0);
+    response.readBytes(temp_buf, debug_len);
+    response.setPosition(original_pos);
+
+    for (size_t i = 0; i < debug_len; i++)
+    {
+        if (temp_buf[i] < 0x10) Serial.print("0");
+        Serial.print(temp_buf[i], HEX);
+        Serial.print(" ");
+    }
+    if (response.getSize() > 128)
+    {
+        Serial.print("...");
+    }
+    Serial.println();
+#endif
+
+    // Check response header
+    uint8_t resp_header[4];
+    response.readBytes(resp_header, 4);
+
+#ifdef RC_DEBUG_INFO
+    for (int i = 0; i < 4; i++)
+    {
+        if (req_header[i] != resp_header[i])
+        {
+            Serial.print("Header mismatch: req=");
+            for (int j = 0; j < 4; j++)
+            {
+                Serial.print(req_header[j], HEX);
+            }
+            Serial.print(", resp=");
+            for (int j = 0; j < 4; j++)
+            {
+                Serial.print(resp_header[j], HEX);
+            }
+            Serial.println();
+            break;
+        }
+    }
+#endif
+
+    return response;
+}
+
+bool RadiaCode::executeAsync(COMMAND reqtype, const uint8_t* args, size_t args_len)
+{
+    // Check if connection is valid
+    if (_connection == nullptr)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Connection is null in executeAsync()");
+#endif
+        return false;
+    }
+
+    // Refuse to overlap two requests; the previous one must be collected first
+    if (_async_pending)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Async request already pending");
+#endif
+        return false;
+    }
+
+    size_t frame_size = buildFrame(reqtype, args, args_len);
+    if (frame_size == 0)
+    {
+        return false;
+    }
+
+    // Keep the request header for the response header check on collection
+    memcpy(_async_req_header, _frame_buffer + 4, sizeof(_async_req_header));
+
+    // Submit request without waiting for the response
+    bool submitted = _connection->executeAsync(_frame_buffer, frame_size);
+
+    if (!submitted)
+    {
+#ifdef RC_DEBUG_WARNING
+        Serial.println("Warning: Transport does not accept async requests");
+#endif
+        return false;
+    }
+
+    _async_pending = true;
+    return true;
+}
+
+BytesBuffer RadiaCode::asyncResponse(void)
+{
+    if (!_async_pending || (_connection == nullptr))
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: No async request pending");
+#endif
+        return BytesBuffer();
+    }
+
+    if (!_connection->responseReady())
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Async response not ready yet");
+#endif
+        return BytesBuffer();
+    }
+
+    _async_pending = false;
+    BytesBuffer response = _connection->takeResponse();
+
+    // Check response header
+    uint8_t resp_header[4];
+    response.readBytes(resp_header, 4);
+
+#ifdef RC_DEBUG_INFO
+    for (int i = 0; i < 4; i++)
+    {
+        if (_async_req_header[i] != resp_header[i])
+        {
+            Serial.println("Header mismatch in async response");
+            break;
+        }
+    }
+#endif
+
+    return response;
+}
+
+bool RadiaCode::asyncPending(void)
+{
+    return _async_pending;
+}
+
+bool RadiaCode::asyncReady(void)
+{
+    if (!_async_pending || (_connection == nullptr))
+    {
+        return false;
+    }
+    return _connection->responseReady();
+}
+
+BytesBuffer RadiaCode::readRequest(uint32_t command_id)
+{
+#ifdef RC_DEBUG_INFO
+    Serial.print("READ_REQ 0x");
+    Serial.print(command_id, HEX);
+    Serial.print(" (");
+    Serial.print(command_id);
+    Serial.print(")");
+#endif
+
+    uint8_t cmd_bytes[4];
+    memcpy(cmd_bytes, &command_id, 4);
+
+    BytesBuffer r = execute(COMMAND::RD_VIRT_STRING, cmd_bytes, 4);
+
+    if (!validateReadResponse(r, command_id))
+    {
+        return BytesBuffer(); // Return empty buffer
+    }
+
+    return r;
+}
+
+bool RadiaCode::readRequestAsync(uint32_t command_id)
+{
+#ifdef RC_DEBUG_INFO
+    Serial.print("READ_REQ_ASYNC 0x");
+    Serial.println(command_id, HEX);
+#endif
+
+    uint8_t cmd_bytes[4];
+    memcpy(cmd_bytes, &command_id, 4);
+
+    if (!executeAsync(COMMAND::RD_VIRT_STRING, cmd_bytes, 4))
+    {
+        return false;
+    }
+
+    _async_command_id = command_id;
+    return true;
+}
+
+bool RadiaCode::validateReadResponse(BytesBuffer& r, uint32_t command_id)
+{
+    // Check if we got a valid response with enough data for header (8 bytes minimum)
+    if (r.getSize() < 8)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.print("Error: Invalid response size for command ");
+        Serial.println(command_id);
+#endif
+        return false;
+    }
+
+    uint32_t retcode = 0;
+    uint32_t flen = 0;
+    bool headerValid = r.readUint32(&retcode) && r.readUint32(&flen);
+
+    if (!headerValid)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Failed to read response header");
+#endif
+        return false;
+    }
+
+#ifdef RC_DEBUG_INFO
+    Serial.print(" -> retcode=");
+    Serial.print(retcode);
+    Serial.print(" len=");
+    Serial.println(flen);
+#endif
+
+#ifdef RC_DEBUG_ERROR
+    if (retcode != 1)
+    {
+        Serial.print("Error: Unexpected return code for command ");
+        Serial.print(command_id, HEX);
+        Serial.print(": ");
+        Serial.println(retcode);
+        // Continue processing anyway
+    }
+#endif
+
+#ifdef RC_DEBUG_WARNING
+    // Add a safety check for the expected data size
+    if (flen > (BytesBuffer::MAX_BUFFER_SIZE - 8))
+    {
+        Serial.print("Warning: Data length too large in readRequest: ");
+        Serial.println(flen);
+    }
+#endif
+
+    // Workaround for firmware bug (if present)
+    size_t remaining_size = r.available();
+    if (remaining_size == (flen + 1))
+    {
+        uint8_t last_byte;
+        r.peekBytes(&last_byte, remaining_size - 1, 1);
+        if (last_byte == 0x00)
+        {
+            // Truncate last byte
+            r.setSize(r.getPosition() + remaining_size - 1);
+        }
+    }
+
+#ifdef RC_DEBUG_ERROR
+    if (r.available() != flen)
+    {
+        Serial.print("Error: Unexpected data size for command ");
+        Serial.print(command_id, HEX);
+        Serial.print(": expected ");
+        Serial.print(flen);
+        Serial.print(", got ");
+        Serial.println(r.available());
+    }
+#endif
+
+  return true;
+}
+
+void RadiaCode::writeRequest(uint32_t command_id, const uint8_t* data, size_t data_len)
+{
+#ifdef RC_DEBUG_INFO
+    Serial.print("WRITE_REQ 0x");
+    Serial.print(command_id, HEX);
+    Serial.print(" (");
+    Serial.print(command_id);
+    Serial.print(") len=");
+    Serial.print(data_len);
+#endif
+
+    // A write makes any cached reading of this register stale, whether it
+    // goes out now or is staged for the transaction commit
+    vsfrCacheInvalidate(command_id);
+
+    // Inside a settings transaction, plain 4-byte VSFR writes are staged
+    // locally and flushed together by commitSettingsTransaction(). Writes
+    // with any other payload shape are not batchable and go out immediately.
+    if (_txn_active && (data != nullptr) && (data_len == 4))
+    {
+        uint32_t value;
+        memcpy(&value, data, 4);
+        stageVSFRWrite(command_id, value);
+        return;
+    }
+
+    // Build the command on the stack; VSFR payloads are at most a few bytes
+    static const size_t MAX_WRITE_DATA = 16;
+    uint8_t cmd_data[4 + MAX_WRITE_DATA];
+
+    if (data_len > MAX_WRITE_DATA)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.print("Error: Write request data too large, len=");
+        Serial.println(data_len);
+#endif
+        return;
+    }
+
+    // Add command ID
+    size_t cmd_size = 4 + (data != nullptr ? data_len : 0);
+    memcpy(cmd_data, &command_id, 4);
+
+    // Add data if present
+    if (data != nullptr && data_len > 0)
+    {
+        memcpy(cmd_data + 4, data, data_len);
+    }
+
+    // Execute command
+    BytesBuffer r = execute(COMMAND::WR_VIRT_SFR, cmd_data, cmd_size);
+
+    // Check response
+    uint32_t retcode;
+    r.readUint32(&retcode);
+
+#ifdef RC_DEBUG_INFO
+    Serial.print(" -> retcode=");
+    Serial.println(retcode);
+#endif
+
+#ifdef RC_DEBUG_ERROR
+    if (retcode != 1)
+    {
+        Serial.print("Write request failed, retcode=");
+        Serial.println(retcode);
+    }
+#endif
+}
+
+void RadiaCode::beginSettingsTransaction(void)
+{
+#ifdef RC_DEBUG_WARNING
+    if (_txn_active && (_txn_count > 0))
+    {
+        Serial.println("Warning: beginSettingsTransaction() discards staged writes");
+    }
+#endif
+
+    _txn_active = true;
+    _txn_count = 0;
+}
+
+bool RadiaCode::commitSettingsTransaction(void)
+{
+    if (!_txn_active)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: commitSettingsTransaction() without an active transaction");
+#endif
+        return false;
+    }
+
+    // Leave transaction mode first so the flush goes over the wire
+    _txn_active = false;
+
+    if (_txn_count == 0)
+    {
+        // Nothing staged; an empty commit is a successful no-op
+        return true;
+    }
+
+    return flushStagedWrites();
+}
+
+void RadiaCode::abortSettingsTransaction(void)
+{
+    // Drop everything staged without touching the device
+    _txn_active = false;
+    _txn_count = 0;
+}
+
+bool RadiaCode::settingsTransactionActive(void)
+{
+    return _txn_active;
+}
+
+void RadiaCode::stageVSFRWrite(uint32_t vsfr_id, uint32_t value)
+{
+    // Re-staging the same register keeps the last value so a transaction
+    // behaves like the sequence of setters it replaces
+    for (size_t i = 0; i < _txn_count; i++)
+    {
+        if (_txn_ids[i] == vsfr_id)
+        {
+            _txn_values[i] = value;
+            return;
+        }
+    }
+
+    // If the staging table is full, flush the complete batch first so no
+    // write is ever dropped; the transaction then continues with a fresh one
+    if (_txn_count >= MAX_STAGED_WRITES)
+    {
+#ifdef RC_DEBUG_WARNING
+        Serial.println("Warning: Settings transaction full, flushing early");
+#endif
+        flushStagedWrites();
+    }
+
+    _txn_ids[_txn_count] = vsfr_id;
+    _txn_values[_txn_count] = value;
+    _txn_count++;
+}
+
+bool RadiaCode::flushStagedWrites(void)
+{
+    size_t num_to_set = _txn_count;
+    if (num_to_set == 0)
+    {
+        return true;
+    }
+
+    // Same message layout as setAlarmLimits(): count, then all IDs, then
+    // all values. The staging table is bounded, so the message fits a
+    // fixed stack buffer.
+    uint8_t msg[4 + MAX_STAGED_WRITES * 4 * 2];
+    size_t msg_size = 4 + num_to_set * 4 * 2;
+
+    // Add count
+    uint32_t count = num_to_set;
+    memcpy(msg, &count, 4);
+
+    // Add IDs
+    for (size_t i = 0; i < num_to_set; i++)
+    {
+        memcpy(msg + 4 + i * 4, &_txn_ids[i], 4);
+    }
+
+    // Add values
+    for (size_t i = 0; i < num_to_set; i++)
+    {
+        memcpy(msg + 4 + num_to_set * 4 + i * 4, &_txn_values[i], 4);
+    }
+
+    // The staged writes are consumed whether or not the batch succeeds
+    _txn_count = 0;
+
+    // Send request
+    BytesBuffer resp = execute(COMMAND::WR_VIRT_SFR_BATCH, msg, msg_size);
+
+    // Check validity flags: one bit per register written
+    uint32_t result;
+    resp.readUint32(&result);
+
+    uint32_t expected_valid = (1 << num_to_set) - 1;
+    if (result != expected_valid)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.print("Error: Batched settings write failed, flags ");
+        Serial.print(result, BIN);
+        Serial.print(" != ");
+        Serial.println(expected_valid, BIN);
+#endif
+        return false;
+    }
+
+    return true;
+}
+
+// TTL policy for one register: settings and calibration registers only
+// change through our own writes, so they stay cached until one of those
+// invalidates them; sensor readings get a short TTL; everything else
+// (time, reset triggers, unknown IDs) is never cached.
+uint32_t RadiaCode::vsfrCacheTTL(uint32_t vsfr_id)
+{
+    switch (vsfr_id)
+    {
+        case VSFR::DEVICE_CTRL:
+        case VSFR::DEVICE_LANG:
+        case VSFR::DEVICE_ON:
+        case VSFR::DISP_CTRL:
+        case VSFR::DISP_BRT:
+        case VSFR::DISP_CONTR:
+        case VSFR::DISP_OFF_TIME:
+        case VSFR::DISP_DIR:
+        case VSFR::SOUND_CTRL:
+        case VSFR::SOUND_ON:
+        case VSFR::VIBRO_CTRL:
+        case VSFR::VIBRO_ON:
+        case VSFR::ALARM_MODE:
+        case VSFR::DR_LEV1_uR_h:
+        case VSFR::DR_LEV2_uR_h:
+        case VSFR::DS_UNITS:
+        case VSFR::CR_LEV1_cp10s:
+        case VSFR::CR_LEV2_cp10s:
+        case VSFR::CHN_TO_keV_A0:
+        case VSFR::CHN_TO_keV_A1:
+        case VSFR::CHN_TO_keV_A2:
+        case VSFR::CR_UNITS:
+        case VSFR::DS_LEV1_uR:
+        case VSFR::DS_LEV2_uR:
+        case VSFR::TEMP_UNITS:
+            return VSFR_TTL_STATIC;
+
+        case VSFR::TEMP_degC:
+        case VSFR::RAW_TEMP_degC:
+        case VSFR::TEMP_UP_degC:
+        case VSFR::TEMP_DN_degC:
+            return VSFR_TTL_TEMP_MS;
+
+        default:
+            return VSFR_TTL_NONE;
+    }
+}
+
+bool RadiaCode::vsfrCacheLookup(uint32_t vsfr_id, uint32_t& value_out)
+{
+    uint32_t ttl = vsfrCacheTTL(vsfr_id);
+    if (ttl == VSFR_TTL_NONE)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < _vsfr_cache_count; i++)
+    {
+        if (_vsfr_cache_ids[i] != vsfr_id)
+        {
+            continue;
+        }
+        if ((ttl != VSFR_TTL_STATIC) && ((millis() - _vsfr_cache_times[i]) > ttl))
+        {
+            return false; // Expired; the fresh read below re-stores it
+        }
+        value_out = _vsfr_cache_values[i];
+        return true;
+    }
+
+    return false;
+}
+
+void RadiaCode::vsfrCacheStore(uint32_t vsfr_id, uint32_t value)
+{
+    if (vsfrCacheTTL(vsfr_id) == VSFR_TTL_NONE)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < _vsfr_cache_count; i++)
+    {
+        if (_vsfr_cache_ids[i] == vsfr_id)
+        {
+            _vsfr_cache_values[i] = value;
+            _vsfr_cache_times[i] = millis();
+            return;
+        }
+    }
+
+    if (_vsfr_cache_count >= VSFR_CACHE_SLOTS)
+    {
+        // Cannot happen while the slot count covers every cacheable
+        // register; the entry is simply not cached
+        return;
+    }
+
+    _vsfr_cache_ids[_vsfr_cache_count] = vsfr_id;
+    _vsfr_cache_values[_vsfr_cache_count] = value;
+    _vsfr_cache_times[_vsfr_cache_count] = millis();
+    _vsfr_cache_count++;
+}
+
+void RadiaCode::vsfrCacheInvalidate(uint32_t vsfr_id)
+{
+    for (size_t i = 0; i < _vsfr_cache_count; i++)
+    {
+        if (_vsfr_cache_ids[i] == vsfr_id)
+        {
+            // Swap the last entry into the hole
+            _vsfr_cache_count--;
+            _vsfr_cache_ids[i] = _vsfr_cache_ids[_vsfr_cache_count];
+            _vsfr_cache_values[i] = _vsfr_cache_values[_vsfr_cache_count];
+            _vsfr_cache_times[i] = _vsfr_cache_times[_vsfr_cache_count];
+            return;
+        }
+    }
+}
+
+// Raw register value to the float representation batchReadVSFRs() returns
+float RadiaCode::convertVSFRValue(uint32_t vsfr_id, uint32_t raw_value)
+{
+    if ((vsfr_id == VSFR::CHN_TO_keV_A0) || (vsfr_id == VSFR::CHN_TO_keV_A1) || (vsfr_id == VSFR::CHN_TO_keV_A2))
+    {
+        // These are float values
+        float float_val;
+        memcpy(&float_val, &raw_value, 4);
+        return float_val;
+    }
+    else if ((vsfr_id == VSFR::DS_UNITS) || (vsfr_id == VSFR::CR_UNITS))
+    {
+        // These are boolean flags in the LSB
+        return raw_value & 0x01;
+    }
+    else if ((vsfr_id == VSFR::TEMP_degC) || (vsfr_id == VSFR::RAW_TEMP_degC) ||
+             (vsfr_id == VSFR::TEMP_UP_degC) || (vsfr_id == VSFR::TEMP_DN_degC))
+    {
+        // Temperature values - these are IEEE-754 float values
+        float float_val;
+        memcpy(&float_val, &raw_value, 4);
+        return float_val;
+    }
+
+    // Most values are integers
+    return (float)raw_value;
+}
+
+std::vector<float> RadiaCode::batchReadVSFRs(const std::vector<uint32_t>& vsfr_ids)
+{
+    std::vector<float> ret;
+
+    size_t nvsfr = vsfr_ids.size();
+    if (nvsfr == 0)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: No VSFRs specified");
+#endif
+        return ret;
+    }
+
+    // Serve the whole batch from the cache when every register is fresh;
+    // redraw-driven getters repeat the same batch, so this is the common
+    // case and costs no radio time at all
+    bool all_cached = true;
+    for (size_t i = 0; i < nvsfr; i++)
+    {
+        uint32_t cached_value;
+        if (!vsfrCacheLookup(vsfr_ids[i], cached_value))
+        {
+            all_cached = false;
+            break;
+        }
+        ret.push_back(convertVSFRValue(vsfr_ids[i], cached_value));
+    }
+    if (all_cached)
+    {
+        return ret;
+    }
+    ret.clear();
+
+    // Prepare message on the stack. The validity-flags response caps a
+    // batch at 32 registers anyway, so the fixed buffer loses nothing.
+    static const size_t MAX_BATCH_VSFRS = 32;
+    if (nvsfr > MAX_BATCH_VSFRS)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Too many VSFRs for one batch read");
+#endif
+        return ret;
+    }
+
+    uint8_t msg[4 + MAX_BATCH_VSFRS * 4]; // 4 bytes for count, 4 bytes per VSFR ID
+    size_t msg_size = 4 + nvsfr * 4;
+
+    // Add count
+    uint32_t count = nvsfr;
+    memcpy(msg, &count, 4);
+
+    // Add VSFR IDs
+    for (size_t i = 0; i < nvsfr; i++)
+    {
+        uint32_t vsfr_id = vsfr_ids[i];
+        memcpy(msg + 4 + i * 4, &vsfr_id, 4);
+    }
+
+    // Send request
+    BytesBuffer r = execute(COMMAND::RD_VIRT_SFR_BATCH, msg, msg_size);
+
+    // Check validity flags
+    uint32_t valid_flags;
+    r.readUint32(&valid_flags);
+
+    // A full 32-register batch needs all flag bits; computing it via
+    // (1 << 32) - 1 would be undefined and wraps to 0 on the ESP32
+    uint32_t expected_flags = (nvsfr >= 32) ? 0xFFFFFFFFu : ((1u << nvsfr) - 1u);
+    if (valid_flags != expected_flags)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.print("Error: Unexpected validity flags, bad vsfr_id? ");
+        Serial.print(valid_flags, BIN);
+        Serial.print(" != ");
+        Serial.println(expected_flags, BIN);
+#endif
+        return ret;
+    }
+
+    // Read values
+    for (size_t i = 0; i < nvsfr; i++)
+    {
+        uint32_t raw_value;
+        r.readUint32(&raw_value);
+
+        // Convert to appropriate type based on VSFR format, and keep the
+        // raw value around for later lookups
+        vsfrCacheStore(vsfr_ids[i], raw_value);
+        ret.push_back(convertVSFRValue(vsfr_ids[i], raw_value));
+    }
+
+    return ret;
+}
+
+uint32_t RadiaCode::readVSFR(uint32_t vsfr_id)
+{
+    // Serve cacheable registers without a round trip while they are fresh
+    uint32_t cached_value;
+    if (vsfrCacheLookup(vsfr_id, cached_value))
+    {
+        return cached_value;
+    }
+
+    // Prepare message on the stack for the single VSFR
+    uint8_t msg[4 + 4]; // 4 bytes for count, 4 bytes for VSFR ID
+
+    // Add count (1 VSFR)
+    uint32_t count = 1;
+    memcpy(msg, &count, 4);
+
+    // Add VSFR ID
+    memcpy(msg + 4, &vsfr_id, 4);
+
+    // Send request
+    BytesBuffer r = execute(COMMAND::RD_VIRT_SFR_BATCH, msg, sizeof(msg));
+
+    // Check validity flags
+    uint32_t valid_flags;
+    r.readUint32(&valid_flags);
+
+    if (valid_flags != 1)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.print("Error: Invalid VSFR ID 0x");
+        Serial.print(vsfr_id, HEX);
+        Serial.print(", validity flags: ");
+        Serial.println(valid_flags, BIN);
+#endif
+        return 0;
+    }
+
+    // Read the single value
+    uint32_t raw_value;
+    r.readUint32(&raw_value);
+
+    vsfrCacheStore(vsfr_id, raw_value);
+    return raw_value;
+}
+
+float RadiaCode::getTemperature(void)
+{
+    std::vector<uint32_t> vsfr_ids = {VSFR::TEMP_degC};
+    std::vector<float> values = batchReadVSFRs(vsfr_ids);
+    if (values.size() > 0)
+    {
+        return values[0];
+    }
+    return 0.0f;
+}
+
+uint32_t RadiaCode::deviceStatus(void)
+{
+    uint32_t flags;
+    BytesBuffer r;
+
+    r = execute(COMMAND::GET_STATUS);
+    r.readUint32(&flags);
+    return flags;
+}
+
+void RadiaCode::setLocalTime(uint8_t day, uint8_t month, uint16_t year, uint8_t second, uint8_t minute, uint8_t hour)
+{
+    uint8_t d[8];
+    d[0] = day;
+    d[1] = month;
+    if (year >= 2000)
+    {
+        d[2] = year - 2000; // 2-digit year
+    }
+    else
+    {
+        d[2] = year - 1900; // 2-digit year
+    }
+    d[3] = 0;
+    d[4] = second;
+    d[5] = minute;
+    d[6] = hour;
+    d[7] = 0;
+
+    execute(COMMAND::SET_TIME, d, sizeof(d));
+}
+
+String RadiaCode::fwSignature(void)
+{
+    uint32_t signature;
+    char buf[256];
+    BytesBuffer r = execute(COMMAND::FW_SIGNATURE);
+
+    r.readUint32(&signature);
+    String filename = r.readString();
+    String idstring = r.readString();
+    sprintf(buf, "Signature: %08lX, FileName=\"%s\", IdString=\"%s\"", signature, filename.c_str(), idstring.c_str());
+    return String(buf);
+}
+
+std::tuple<int, int, String, int, int, String> RadiaCode::fwVersion(void)
+{
+    BytesBuffer r;
+    uint16_t boot_minor, boot_major, target_minor, target_major;
+    String boot_date, target_date;
+
+    r = execute(COMMAND::GET_VERSION);
+    r.readUint16(&boot_minor);
+    r.readUint16(&boot_major);
+    boot_date = r.readString();
+
+    r.readUint16(&target_minor);
+    r.readUint16(&target_major);
+
+    target_date = r.readString();
+    target_date.remove(target_date.length() - 1);  // Remove trailing null byte
+
+    return std::make_tuple(boot_major, boot_minor, boot_date, target_major, target_minor, target_date);
+}
+
+size_t RadiaCode::fwSignature(char* buffer, size_t buffer_size)
+{
+    uint32_t signature;
+    char filename[64];
+    char idstring[64];
+
+    if ((buffer == nullptr) || (buffer_size == 0))
+    {
+        return 0;
+    }
+    buffer[0] = '\0';
+
+    BytesBuffer r = execute(COMMAND::FW_SIGNATURE);
+
+    if (!r.readUint32(&signature))
+    {
+        return 0;
+    }
+    r.readStringInto(filename, sizeof(filename));
+    r.readStringInto(idstring, sizeof(idstring));
+
+    int written = snprintf(buffer, buffer_size, "Signature: %08lX, FileName=\"%s\", IdString=\"%s\"",
+                           (unsigned long)signature, filename, idstring);
+    if (written < 0)
+    {
+        buffer[0] = '\0';
+        return 0;
+    }
+    if ((size_t)written >= buffer_size)
+    {
+        return buffer_size - 1; // Truncated by snprintf
+    }
+    return (size_t)written;
+}
+
+bool RadiaCode::fwVersion(FwVersion& version_out)
+{
+    BytesBuffer r;
+    uint16_t boot_minor, boot_major, target_minor, target_major;
+
+    r = execute(COMMAND::GET_VERSION);
+    if (!r.readUint16(&boot_minor) || !r.readUint16(&boot_major))
+    {
+        return false;
+    }
+    version_out.boot_minor = boot_minor;
+    version_out.boot_major = boot_major;
+    r.readStringInto(version_out.boot_date, sizeof(version_out.boot_date));
+
+    if (!r.readUint16(&target_minor) || !r.readUint16(&target_major))
+    {
+        return false;
+    }
+    version_out.target_minor = target_minor;
+    version_out.target_major = target_major;
+
+    size_t date_len = r.readStringInto(version_out.target_date, sizeof(version_out.target_date));
+    if (date_len > 0)
+    {
+        version_out.target_date[date_len - 1] = '\0'; // Remove trailing null byte
+    }
+
+    return true;
+}
+
+String RadiaCode::hwSerialNumber(void)
+{
+    uint32_t serial_len;
+    BytesBuffer r = execute(COMMAND::GET_SERIAL);
+
+    r.readUint32(&serial_len);
+
+    if ((serial_len % 4) != 0)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Serial number length is not a multiple of 4");
+#endif
+        return "";
+    }
+
+    String serial = "";
+    for (uint32_t i = 0; i < (serial_len / 4); i++)
+    {
+        uint32_t group;
+        r.readUint32(&group);
+        char buf[10];
+        sprintf(buf, "%08lX", group);
+        if (i > 0) serial += "-";
+        serial += buf;
+    }
+
+    return serial;
+}
+
+String RadiaCode::configuration(void)
+{
+    String result;
+    BytesBuffer r = readRequest(VS::CONFIGURATION);
+
+    size_t len = r.available();
+    char* buffer = new char[len + 1];
+    r.readBytes((uint8_t*)buffer, len);
+    buffer[len] = '\0';
+    result = String(buffer);
+    delete[] buffer;
+    return result;
+}
+
+String RadiaCode::textMessage(void)
+{
+    BytesBuffer r = readRequest(VS::TEXT_MESSAGE);
+
+    size_t len = r.available();
+    char* buffer = new char[len + 1];
+    r.readBytes((uint8_t*)buffer, len);
+    buffer[len] = '\0';
+
+    String result = String(buffer);
+    delete[] buffer;
+
+    return result;
+}
+
+String RadiaCode::serialNumber(void)
+{
+    String result;
+    size_t len;
+    BytesBuffer r;
+    char* buffer;
+
+    r = readRequest(VS::SERIAL_NUMBER);
+    len = r.available();
+    buffer = new char[len + 1];
+    r.readBytes((uint8_t*)buffer, len);
+    buffer[len] = '\0';
+    result = String(buffer);
+    delete[] buffer;
+    return result;
+}
+
+size_t RadiaCode::configuration(char* buffer, size_t buffer_size)
+{
+    if ((buffer == nullptr) || (buffer_size == 0))
+    {
+        return 0;
+    }
+
+    BytesBuffer r = readRequest(VS::CONFIGURATION);
+
+    size_t len = r.available();
+    if (len > (buffer_size - 1))
+    {
+#ifdef RC_DEBUG_WARNING
+        Serial.println("Warning: Configuration truncated to caller buffer");
+#endif
+        len = buffer_size - 1;
+    }
+    len = r.readBytes((uint8_t*)buffer, len);
+    buffer[len] = '\0';
+    return len;
+}
+
+size_t RadiaCode::textMessage(char* buffer, size_t buffer_size)
+{
+    if ((buffer == nullptr) || (buffer_size == 0))
+    {
+        return 0;
+    }
+
+    BytesBuffer r = readRequest(VS::TEXT_MESSAGE);
+
+    size_t len = r.available();
+    if (len > (buffer_size - 1))
+    {
+#ifdef RC_DEBUG_WARNING
+        Serial.println("Warning: Text message truncated to caller buffer");
+#endif
+        len = buffer_size - 1;
+    }
+    len = r.readBytes((uint8_t*)buffer, len);
+    buffer[len] = '\0';
+    return len;
+}
+
+size_t RadiaCode::serialNumber(char* buffer, size_t buffer_size)
+{
+    if ((buffer == nullptr) || (buffer_size == 0))
+    {
+        return 0;
+    }
+
+    BytesBuffer r = readRequest(VS::SERIAL_NUMBER);
+
+    size_t len = r.available();
+    if (len > (buffer_size - 1))
+    {
+#ifdef RC_DEBUG_WARNING
+        Serial.println("Warning: Serial number truncated to caller buffer");
+#endif
+        len = buffer_size - 1;
+    }
+    len = r.readBytes((uint8_t*)buffer, len);
+    buffer[len] = '\0';
+    return len;
+}
+
+String RadiaCode::commands(void)
+{
+    BytesBuffer r = readRequest(VS::SFR_FILE);
+
+    size_t len = r.available();
+    char* buffer = new char[len + 1];
+    r.readBytes((uint8_t*)buffer, len);
+    buffer[len] = '\0';
+
+    String result = String(buffer);
+    delete[] buffer;
+
+    return result;
+}
+
+void RadiaCode::deviceTime(uint32_t v)
+{
+    uint8_t data[4];
+    memcpy(data, &v, 4);
+
+    writeRequest(VSFR::DEVICE_TIME, data, 4);
+}
+
+std::vector<DataItem*> RadiaCode::dataBuf(void)
+{
+    BytesBuffer r = readRequest(VS::DATA_BUF);
+    return decodeDataBuf(r, _base_time_sec, &_alarm_monitor);
+}
+
+size_t RadiaCode::dataBufPooled(void)
+{
+    BytesBuffer r = readRequest(VS::DATA_BUF);
+    return decodeDataBuf(r, _base_time_sec, _data_pool, &_alarm_monitor);
+}
+
+DataItemPool& RadiaCode::dataPool(void)
+{
+    return _data_pool;
+}
+
+size_t RadiaCode::dataBuf(DataItemRecord* records, size_t max_records)
+{
+    BytesBuffer r = readRequest(VS::DATA_BUF);
+    return decodeDataBuf(r, _base_time_sec, records, max_records, &_alarm_monitor);
+}
+
+bool RadiaCode::startStreaming(uint32_t poll_interval_ms)
+{
+    // Equal bounds disable the adaptive scheduler: a plain fixed cadence
+    return startStreaming(poll_interval_ms, poll_interval_ms);
+}
+
+bool RadiaCode::startStreaming(uint32_t min_interval_ms, uint32_t max_interval_ms)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    if (_stream_task != nullptr)
+    {
+        return true; // Already running
+    }
+
+    if (_connection == nullptr)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Cannot stream without a connection");
+#endif
+        return false;
+    }
+
+    // Keep the cadence sane: the device refills DATA_BUF at ~1 Hz and a
+    // full BLE exchange takes tens of milliseconds
+    if (min_interval_ms < 100)
+    {
+        min_interval_ms = 100;
+    }
+    if (max_interval_ms < min_interval_ms)
+    {
+        max_interval_ms = min_interval_ms;
+    }
+
+    // Ring and decode scratch live only while streaming runs
+    _stream_ring = new DataItemRecord[STREAM_RING_SIZE];
+    _stream_scratch = new DataItemRecord[STREAM_SCRATCH_SIZE];
+    _stream_head = 0;
+    _stream_tail = 0;
+    _stream_dropped = 0;
+    _stream_min_interval_ms = min_interval_ms;
+    _stream_max_interval_ms = max_interval_ms;
+
+    // Start in the middle of the band and let the yield of the first few
+    // polls pull the cadence to where the data rate actually is
+    _stream_interval_ms = (min_interval_ms + max_interval_ms) / 2;
+
+    // Poll on core 0 next to the BLE stack so the application core only
+    // ever touches the ring
+    _stream_run = true;
+    BaseType_t created = xTaskCreatePinnedToCore(
+        streamTaskEntry,
+        "rc_stream",
+        6144,
+        this,
+        1,
+        &_stream_task,
+        0);
+
+    if (created != pdPASS)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Failed to create streaming task");
+#endif
+        _stream_task = nullptr;
+        _stream_run = false;
+        stopStreaming();
+        return false;
+    }
+
+    return true;
+#else
+    (void)min_interval_ms;
+    (void)max_interval_ms;
+    return false;
+#endif
+}
+
+uint32_t RadiaCode::streamInterval(void)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    return _stream_interval_ms;
+#else
+    return 0;
+#endif
+}
+
+void RadiaCode::stopStreaming(void)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    if (_stream_task != nullptr)
+    {
+        // The task clears _stream_task on its way out; wait for that so
+        // the ring below is guaranteed unused
+        _stream_run = false;
+        while (_stream_task != nullptr)
+        {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+    _stream_run = false;
+
+    if (_stream_ring != nullptr)
+    {
+        delete[] _stream_ring;
+        _stream_ring = nullptr;
+    }
+
+    if (_stream_scratch != nullptr)
+    {
+        delete[] _stream_scratch;
+        _stream_scratch = nullptr;
+    }
+#endif
+}
+
+bool RadiaCode::streamingActive(void)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    return (_stream_task != nullptr);
+#else
+    return false;
+#endif
+}
+
+size_t RadiaCode::readStream(DataItemRecord* records, size_t max_records)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    if ((records == nullptr) || (_stream_ring == nullptr))
+    {
+        return 0;
+    }
+
+    size_t n_read = 0;
+    uint32_t tail = _stream_tail;
+
+    while (n_read < max_records)
+    {
+        uint32_t head = _stream_head;
+
+        // If the producer lapped us, the oldest unread slots have been
+        // (or are being) overwritten; skip past them and count the loss.
+        // The producer fills the slot before publishing its head, so a
+        // distance of exactly STREAM_RING_SIZE can already mean a write
+        // in progress - stay strictly inside the ring.
+        if ((head - tail) >= STREAM_RING_SIZE)
+        {
+            uint32_t skipped = (head - (STREAM_RING_SIZE - 1)) - tail;
+            _stream_dropped = _stream_dropped + skipped;
+            tail = head - (STREAM_RING_SIZE - 1);
+        }
+
+        if (tail == head)
+        {
+            break; // Ring drained
+        }
+
+        records[n_read] = _stream_ring[tail % STREAM_RING_SIZE];
+
+        // Re-check after the copy: if the producer reached our slot while
+        // we copied, the record may be torn - drop it and let the lap
+        // check above move tail forward, so the loop always progresses
+        if ((_stream_head - tail) >= STREAM_RING_SIZE)
+        {
+            continue;
+        }
+
+        tail++;
+        n_read++;
+    }
+
+    _stream_tail = tail;
+    return n_read;
+#else
+    (void)records;
+    (void)max_records;
+    return 0;
+#endif
+}
+
+size_t RadiaCode::streamAvailable(void)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    // Can momentarily exceed the ring size when the producer has lapped
+    // the consumer; the excess is dropped on the next readStream()
+    uint32_t pending = _stream_head - _stream_tail;
+    if (pending > STREAM_RING_SIZE)
+    {
+        pending = STREAM_RING_SIZE;
+    }
+    return (size_t)pending;
+#else
+    return 0;
+#endif
+}
+
+uint32_t RadiaCode::streamDropped(void)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    return _stream_dropped;
+#else
+    return 0;
+#endif
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+void RadiaCode::streamTaskEntry(void* param)
+{
+    RadiaCode* self = (RadiaCode*)param;
+
+    if (self != nullptr)
+    {
+        self->streamTaskLoop();
+        // Signal stopStreaming() that the ring is no longer touched
+        self->_stream_task = nullptr;
+    }
+
+    vTaskDelete(nullptr);
+}
+
+void RadiaCode::streamTaskLoop(void)
+{
+    while (_stream_run)
+    {
+        // Fetch and decode the next batch with the existing flat-record path
+        size_t n_records = dataBuf(_stream_scratch, STREAM_SCRATCH_SIZE);
+
+        for (size_t i = 0; (i < n_records) && _stream_run; i++)
+        {
+            // Overwrite-oldest backpressure: the producer writes into a
+            // free-running ring and never touches the tail - the consumer
+            // detects being lapped from the head distance, skips forward
+            // and counts the loss itself. Keeping each index single-writer
+            // is what makes the lock-free scheme sound.
+            uint32_t head = _stream_head;
+            _stream_ring[head % STREAM_RING_SIZE] = _stream_scratch[i];
+            _stream_head = head + 1;
+        }
+
+        // Adaptive cadence: scale the interval by what this poll yielded.
+        // A near-full batch means the device-side buffer is filling faster
+        // than we drain it, so halve the interval; a near-empty poll means
+        // we are burning airtime on a quiet device, so back off by half.
+        // Multiplicative steps settle within a few polls from either end.
+        if (_stream_min_interval_ms != _stream_max_interval_ms)
+        {
+            uint32_t interval = _stream_interval_ms;
+
+            if (n_records >= (STREAM_SCRATCH_SIZE / 2))
+            {
+                interval /= 2;
+            }
+            else if (n_records <= (STREAM_SCRATCH_SIZE / 16))
+            {
+                interval += interval / 2;
+            }
+
+            if (interval < _stream_min_interval_ms)
+            {
+                interval = _stream_min_interval_ms;
+            }
+            if (interval > _stream_max_interval_ms)
+            {
+                interval = _stream_max_interval_ms;
+            }
+            _stream_interval_ms = interval;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(_stream_interval_ms));
+    }
+}
+#endif
+
+Spectrum RadiaCode::spectrum(void)
+{
+    // Reuse the per-instance scratch object
+    Spectrum& result = _spectrum_scratch;
+
+    // Clear the object for reuse
+    result.clear();
+
+    // Decode the response while it is still being received: the transport
+    // tees each incoming fragment to the incremental decoder, so by the
+    // time the last packet lands the Spectrum is already populated and the
+    // buffered decode below is skipped
+    SpectrumStreamDecoder streamer;
+    if (_connection != nullptr)
+    {
+        streamer.begin(_spectrum_format_version, &result);
+        _connection->setFragmentSink(SpectrumStreamDecoder::feedThunk, &streamer);
+    }
+
+    // Get the raw spectrum data
+    BytesBuffer r = readRequest(VS::SPECTRUM);
+
+    if (_connection != nullptr)
+    {
+        _connection->setFragmentSink(nullptr, nullptr);
+    }
+
+    if (streamer.complete())
+    {
+        // Keep the energy lookup table aligned with the decoded calibration
+        _energy_lut.update(result.a0, result.a1, result.a2);
+        return result;
+    }
+
+    // Fall back to the buffered decode: the transport delivers no
+    // fragments early, or the stream decode bailed out part way
+
+    // Check if we got valid data back
+    if (r.getSize() < 16)
+    { // Minimum size for header (duration + a0,a1,a2)
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Invalid or empty spectrum data received");
+#endif
+        return result; // Return empty spectrum
+    }
+
+    // Process the buffer directly into our static object
+    decodeSpectrum(r, _spectrum_format_version, result);
+
+    // Keep the energy lookup table aligned with the decoded calibration
+    // (a no-op while the coefficients are unchanged)
+    _energy_lut.update(result.a0, result.a1, result.a2);
+
+#ifdef RC_DEBUG_WARNING
+    // Safety check - make sure we got some data
+    if (result.count_size == 0)
+    {
+        Serial.println("Warning: No spectrum data points decoded");
+    }
+#endif
+
+    // Return a copy
+    return result;
+}
+
+Spectrum RadiaCode::spectrumAccum(void)
+{
+    // Reuse the per-instance scratch object
+    Spectrum& result = _spectrum_scratch;
+
+    // Clear the object for reuse
+    result.clear();
+
+    // Stream-decode overlapped with reception, as in spectrum()
+    SpectrumStreamDecoder streamer;
+    if (_connection != nullptr)
+    {
+        streamer.begin(_spectrum_format_version, &result);
+        _connection->setFragmentSink(SpectrumStreamDecoder::feedThunk, &streamer);
+    }
+
+    // Get the raw spectrum data
+    BytesBuffer r = readRequest(VS::SPEC_ACCUM);
+
+    if (_connection != nullptr)
+    {
+        _connection->setFragmentSink(nullptr, nullptr);
+    }
+
+    if (streamer.complete())
+    {
+        // Keep the energy lookup table aligned with the decoded calibration
+        _energy_lut.update(result.a0, result.a1, result.a2);
+        return result;
+    }
+
+    // Check if we got valid data back
+    if (r.getSize() < 16)
+    { // Minimum size for header (duration + a0,a1,a2)
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Invalid or empty accumulated spectrum data received");
+#endif
+        return result; // Return empty spectrum
+    }
+
+    // Process the buffer directly into our static object
+    decodeSpectrum(r, _spectrum_format_version, result);
+
+    // Keep the energy lookup table aligned with the decoded calibration
+    _energy_lut.update(result.a0, result.a1, result.a2);
+
+#ifdef RC_DEBUG_WARNING
+    // Safety check - make sure we got some data
+    if (result.count_size == 0)
+    {
+        Serial.println("Warning: No accumulated spectrum data points decoded");
+    }
+#endif
+
+    // Return a copy
+    return result;
+}
+
+bool RadiaCode::spectrumAsync(void)
+{
+    return readRequestAsync(VS::SPECTRUM);
+}
+
+bool RadiaCode::spectrumAccumAsync(void)
+{
+    return readRequestAsync(VS::SPEC_ACCUM);
+}
+
+bool RadiaCode::dataBufAsync(void)
+{
+    return readRequestAsync(VS::DATA_BUF);
+}
+
+bool RadiaCode::spectrumAsyncResult(Spectrum& spectrum_out)
+{
+    uint32_t command_id = _async_command_id;
+
+    // Collect and validate the completed virtual string response
+    BytesBuffer r = asyncResponse();
+    if (!validateReadResponse(r, command_id))
+    {
+        return false;
+    }
+
+    // Check if we got valid data back
+    if (r.getSize() < 16)
+    { // Minimum size for header (duration + a0,a1,a2)
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Invalid or empty spectrum data received");
+#endif
+        return false;
+    }
+
+    decodeSpectrum(r, _spectrum_format_version, spectrum_out);
+    return true;
+}
+
+std::vector<DataItem*> RadiaCode::dataBufAsyncResult(void)
+{
+    uint32_t command_id = _async_command_id;
+
+    // Collect and validate the completed virtual string response
+    BytesBuffer r = asyncResponse();
+    if (!validateReadResponse(r, command_id))
+    {
+        return std::vector<DataItem*>();
+    }
+
+    return decodeDataBuf(r, _base_time_sec, &_alarm_monitor);
+}
+
+bool RadiaCode::startSpectrumPrefetch(void)
+{
+    if (_prefetch_active)
+    {
+        return true;
+    }
+
+    if (_async_pending)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Another async request is in flight, cannot start prefetch");
+#endif
+        return false;
+    }
+
+    // Launch the first fetch; spectrumSwap() collects it and keeps the
+    // pipeline primed from then on
+    if (!spectrumAsync())
+    {
+        return false;
+    }
+
+    _prefetch_front = 0;
+    _prefetch_active = true;
+    return true;
+}
+
+const Spectrum* RadiaCode::spectrumSwap(uint32_t timeout_ms)
+{
+    if (!_prefetch_active && !startSpectrumPrefetch())
+    {
+        return nullptr;
+    }
+
+    // Wait for the in-flight fetch; when processing took longer than the
+    // transfer this returns immediately
+    uint32_t wait_start = millis();
+    while (!asyncReady())
+    {
+        if (!asyncPending())
+        {
+            // The pipeline lost its request (e.g. a blocking call ran in
+            // between); re-prime it and report this swap as failed
+            _prefetch_active = false;
+            startSpectrumPrefetch();
+            return nullptr;
+        }
+        if ((millis() - wait_start) > timeout_ms)
+        {
+#ifdef RC_DEBUG_WARNING
+            Serial.println("Warning: Timeout waiting for prefetched spectrum");
+#endif
+            return nullptr; // The fetch stays pending for the next swap
+        }
+        delay(1);
+        yield();
+    }
+
+    // Decode into the back buffer while the application may still hold a
+    // pointer to the front one
+    uint8_t back = (uint8_t)(1 - _prefetch_front);
+    bool decoded = spectrumAsyncResult(_prefetch_spectra[back]);
+
+    // Start the next transfer before returning, so it overlaps whatever
+    // processing the application does next
+    if (!spectrumAsync())
+    {
+#ifdef RC_DEBUG_WARNING
+        Serial.println("Warning: Failed to start next prefetch, pipeline stopped");
+#endif
+        _prefetch_active = false;
+    }
+
+    if (!decoded)
+    {
+        return nullptr; // Bad frame; the front buffer is untouched
+    }
+
+    _prefetch_front = back;
+
+    // Keep the energy lookup table aligned with the decoded calibration
+    _energy_lut.update(_prefetch_spectra[back].a0, _prefetch_spectra[back].a1,
+        _prefetch_spectra[back].a2);
+
+    return &_prefetch_spectra[_prefetch_front];
+}
+
+void RadiaCode::stopSpectrumPrefetch(void)
+{
+    if (!_prefetch_active)
+    {
+        return;
+    }
+    _prefetch_active = false;
+
+    // Drain the in-flight fetch so the transport is free for blocking
+    // calls again; bounded wait in case the link already dropped
+    uint32_t wait_start = millis();
+    while (asyncPending() && !asyncReady())
+    {
+        if ((millis() - wait_start) > 5000)
+        {
+#ifdef RC_DEBUG_WARNING
+            Serial.println("Warning: In-flight prefetch did not complete during stop");
+#endif
+            return;
+        }
+        delay(1);
+        yield();
+    }
+
+    if (asyncReady())
+    {
+        asyncResponse(); // Discard
+    }
+}
+
+bool RadiaCode::spectrumPrefetchActive(void)
+{
+    return _prefetch_active;
+}
+
+bool RadiaCode::startPipelinedDataBuf(void)
+{
+    if (_pipelined_databuf_active)
+    {
+        return true;
+    }
+
+    if (_connection == nullptr)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Connection is null in startPipelinedDataBuf()");
+#endif
+        return false;
+    }
+
+    if (_async_pending)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: An async request is in flight, cannot start pipelined polling");
+#endif
+        return false;
+    }
+
+    if (!_connection->startPipeline())
+    {
+#ifdef RC_DEBUG_WARNING
+        Serial.println("Warning: Transport has no pipelined mode");
+#endif
+        return false;
+    }
+
+    // Put the first poll on the air; dataBufPipelined() keeps one request
+    // in flight from here on
+    uint8_t cmd_bytes[4];
+    uint32_t command_id = VS::DATA_BUF;
+    memcpy(cmd_bytes, &command_id, 4);
+
+    size_t frame_size = buildFrame(COMMAND::RD_VIRT_STRING, cmd_bytes, 4);
+    if ((frame_size == 0) || !_connection->pipelineSubmit(_frame_buffer, frame_size))
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Failed to submit the first pipelined poll");
+#endif
+        _connection->stopPipeline();
+        return false;
+    }
+
+    _pipelined_databuf_active = true;
+    return true;
+}
+
+size_t RadiaCode::dataBufPipelined(DataItemRecord* records, size_t max_records, uint32_t timeout_ms)
+{
+    if (!_pipelined_databuf_active || (records == nullptr) || (_connection == nullptr))
+    {
+        return 0;
+    }
+
+    // Collect the completed poll; the view stays valid until one further
+    // response lands, which cannot happen before the submit below
+    BytesBuffer r;
+    if (!_connection->pipelineReceive(r, timeout_ms))
+    {
+        return 0; // Timeout; the in-flight poll answers a later call
+    }
+
+    // Submit the next poll before decoding this one, so the radio exchange
+    // runs on the transport task while we decode here
+    uint8_t cmd_bytes[4];
+    uint32_t command_id = VS::DATA_BUF;
+    memcpy(cmd_bytes, &command_id, 4);
+
+    size_t frame_size = buildFrame(COMMAND::RD_VIRT_STRING, cmd_bytes, 4);
+    if ((frame_size == 0) || !_connection->pipelineSubmit(_frame_buffer, frame_size))
+    {
+#ifdef RC_DEBUG_WARNING
+        Serial.println("Warning: Failed to submit the next pipelined poll, pipeline stopped");
+#endif
+        stopPipelinedDataBuf();
+    }
+
+    // The pipeline hands over the payload after the command header; the
+    // usual retcode and length checks apply
+    uint8_t resp_header[4];
+    r.readBytes(resp_header, 4);
+    if (!validateReadResponse(r, command_id))
+    {
+        return 0;
+    }
+
+    return decodeDataBuf(r, _base_time_sec, records, max_records, &_alarm_monitor);
+}
+
+void RadiaCode::stopPipelinedDataBuf(void)
+{
+    if (!_pipelined_databuf_active)
+    {
+        return;
+    }
+    _pipelined_databuf_active = false;
+
+    if (_connection != nullptr)
+    {
+        _connection->stopPipeline();
+    }
+}
+
+bool RadiaCode::pipelinedDataBufActive(void)
+{
+    return _pipelined_databuf_active;
+}
+
+Spectrum RadiaCode::spectrumDiff(void)
+{
+    // First call: seed the per-instance accumulation with a full spectrum
+    // fetch. Reading SPEC_DIFF also arms the device-side delta tracking, so
+    // subsequent calls only transfer the channels that changed.
+    if (!_diff_seeded)
+    {
+        _diff_accum = spectrum();
+
+        // Arm the device-side delta by consuming the pending SPEC_DIFF
+        // read; its content is already covered by the full fetch above
+        // (other seeded caches still receive it)
+        fetchSpectrumDelta();
+
+        _diff_seeded = true;
+        return _diff_accum;
+    }
+
+    // Fetch the delta since the last SPEC_DIFF read and merge it into the
+    // local accumulation (and any other seeded cache)
+    if (!fetchSpectrumDelta())
+    {
+        Spectrum& result = _spectrum_scratch;
+        result.clear();
+        return result; // Return empty spectrum
+    }
+
+    // Return a copy of the merged totals
+    return _diff_accum;
+}
+
+Spectrum RadiaCode::spectrumAccumCached(void)
+{
+    // First call: take a full snapshot of the device accumulator, then arm
+    // the delta stream so later calls only transfer the changed channels
+    if (!_accum_seeded)
+    {
+        _accum_cache = spectrumAccum();
+
+        // Consume the pending delta before marking the cache seeded, so
+        // counts already covered by the snapshot are not merged twice
+        fetchSpectrumDelta();
+
+        _accum_seeded = true;
+        return _accum_cache;
+    }
+
+    // Steady state: one small delta transfer updates the cached totals
+    fetchSpectrumDelta();
+    return _accum_cache;
+}
+
+bool RadiaCode::fetchSpectrumDelta(void)
+{
+    // Decode the delta into the scratch object
+    Spectrum& delta = _spectrum_scratch;
+    delta.clear();
+
+    BytesBuffer r = readRequest(VS::SPEC_DIFF);
+
+    // Check if we got valid data back
+    if (r.getSize() < 16)
+    { // Minimum size for header (duration + a0,a1,a2)
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Invalid or empty differential spectrum data received");
+#endif
+        return false;
+    }
+
+    decodeSpectrum(r, _spectrum_format_version, delta);
+
+    // One delta stream feeds every seeded cache: the device reports each
+    // increment exactly once, so it has to be applied everywhere at once
+    if (_diff_seeded)
+    {
+        if (delta.count_size > _diff_accum.count_size)
+        {
+            _diff_accum.count_size = delta.count_size;
+        }
+        for (size_t i = 0; i < delta.count_size; i++)
+        {
+            _diff_accum.counts[i] += delta.counts[i];
+        }
+
+        // Carry the delta's header metadata over to the accumulation
+        _diff_accum.duration_sec = delta.duration_sec;
+        _diff_accum.a0 = delta.a0;
+        _diff_accum.a1 = delta.a1;
+        _diff_accum.a2 = delta.a2;
+    }
+
+    if (_accum_seeded)
+    {
+        if (delta.count_size > _accum_cache.count_size)
+        {
+            _accum_cache.count_size = delta.count_size;
+        }
+        for (size_t i = 0; i < delta.count_size; i++)
+        {
+            _accum_cache.counts[i] += delta.counts[i];
+        }
+
+        // Keep the calibration current; the duration stays that of the
+        // last full snapshot (the delta's duration describes the live
+        // spectrum, not the accumulator)
+        _accum_cache.a0 = delta.a0;
+        _accum_cache.a1 = delta.a1;
+        _accum_cache.a2 = delta.a2;
+    }
+
+    return true;
+}
+
+void RadiaCode::doseReset(void)
+{
+    writeRequest(VSFR::DOSE_RESET);
+}
+
+void RadiaCode::spectrumReset(void)
+{
+    // The device spectrum restarts from zero, so the differential
+    // accumulation and the cached device accumulator both have to be
+    // re-seeded on their next call
+    _diff_seeded = false;
+    _diff_accum.clear();
+    _accum_seeded = false;
+    _accum_cache.clear();
+
+    uint32_t cmd = VS::SPECTRUM;
+    uint32_t size = 0;
+
+    uint8_t data[8];
+    memcpy(data, &cmd, 4);
+    memcpy(data + 4, &size, 4);
+
+    BytesBuffer r = execute(COMMAND::WR_VIRT_STRING, data, 8);
+
+    uint32_t retcode;
+    r.readUint32(&retcode);
+
+#ifdef RC_DEBUG_ERROR
+    if (retcode != 1)
+    {
+        Serial.print("Spectrum reset failed, retcode=");
+        Serial.println(retcode);
+    }
+#endif
+}
+
+std::vector<float> RadiaCode::energyCalib(void)
+{
+    BytesBuffer r;
+    std::vector<float> coefficients;
+
+    r = readRequest(VS::ENERGY_CALIB);
+    for (int i = 0; i < 3; i++)
+    {
+        float coef;
+        r.readFloat(&coef);
+        coefficients.push_back(coef);
+    }
+
+    return coefficients;
+}
+
+void RadiaCode::setEnergyCalib(float a0, float a1, float a2)
+{
+    uint32_t retcode;
+    BytesBuffer r;
+    uint8_t  pc[12]; // 3 floats * 4 bytes each
+    uint32_t cmd = VS::ENERGY_CALIB;
+    uint32_t size = sizeof(pc);
+    uint8_t  data[8 + sizeof(pc)];
+
+    memcpy(pc, &a0, 4);
+    memcpy(pc + 4, &a1, 4);
+    memcpy(pc + 8, &a2, 4);
+    memcpy(data, &cmd, 4);
+    memcpy(data + 4, &size, 4);
+    memcpy(data + 8, pc, sizeof(pc));
+    r = execute(COMMAND::WR_VIRT_STRING, data, 8 + sizeof(pc));
+    r.readUint32(&retcode);
+
+#ifdef RC_DEBUG_ERROR
+    if (retcode != 1)
+    {
+        Serial.print("Set energy calibration failed, retcode=");
+        Serial.println(retcode);
+    }
+#endif
+
+    // The device calibration changed; drop the cached coefficient
+    // registers and refresh the lookup table so stale energies are never
+    // served
+    vsfrCacheInvalidate(VSFR::CHN_TO_keV_A0);
+    vsfrCacheInvalidate(VSFR::CHN_TO_keV_A1);
+    vsfrCacheInvalidate(VSFR::CHN_TO_keV_A2);
+    _energy_lut.invalidate();
+    if (retcode == 1)
+    {
+        _energy_lut.update(a0, a1, a2);
+    }
+}
+
+AlarmMonitor& RadiaCode::alarmMonitor(void)
+{
+    return _alarm_monitor;
+}
+
+EnergyCalibLUT& RadiaCode::energyCalibLUT(void)
+{
+    // The table normally refreshes itself from fetched spectra; if none
+    // has been seen yet, read the coefficients from the device once
+    if (!_energy_lut.valid())
+    {
+        std::vector<float> coefficients = energyCalib();
+        if (coefficients.size() >= 3)
+        {
+            _energy_lut.update(coefficients[0], coefficients[1], coefficients[2]);
+        }
+    }
+
+    return _energy_lut;
+}
+
+uint8_t RadiaCode::getSpectrumFormatVersion(void)
+{
+    return _spectrum_format_version;
+}
+
+void RadiaCode::setLanguage(const char* lang)
+{
+    if ((strcmp(lang, "ru") != 0) && (strcmp(lang, "en") != 0))
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Unsupported language. Use 'ru' or 'en'");
+#endif
+        return;
+    }
+
+    uint32_t value = (strcmp(lang, "en") == 0) ? 1 : 0;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::DEVICE_LANG, data, 4);
+}
+
+void RadiaCode::setDeviceOn(bool on)
+{
+    uint32_t value = on ? 1 : 0;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::DEVICE_ON, data, 4);
+}
+
+void RadiaCode::setSoundOn(bool on)
+{
+    uint32_t value = on ? 1 : 0;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::SOUND_ON, data, 4);
+}
+
+void RadiaCode::setVibroOn(bool on)
+{
+    uint32_t value = on ? 1 : 0;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::VIBRO_ON, data, 4);
+}
+
+void RadiaCode::setLightOn(bool on)
+{
+    uint8_t data[4];
+    uint32_t deviceCtrl = readVSFR(VSFR::DEVICE_CTRL);
+    if (on)
+    {
+        deviceCtrl |= DEV_CTRL::LIGHT;
+    }
+    else
+    {
+        deviceCtrl &= ~DEV_CTRL::LIGHT;
+    }
+    memcpy(data, &deviceCtrl, 4);
+    writeRequest(VSFR::DEVICE_CTRL, data, 4);
+}
+
+void RadiaCode::setDeviceCtrl(DEV_CTRL ctrl_flags)
+{
+    uint8_t data[4];
+    uint32_t value = (ctrl_flags & ~DEV_CTRL::BIT_1) | DEV_CTRL::BIT_5; // Ensure BIT1 is always 0 and BIT5 is always 1
+
+    memcpy(data, &value, 4);
+    writeRequest(VSFR::DEVICE_CTRL, data, 4);
+}
+
+void RadiaCode::setSoundCtrl(CTRL ctrl_flags)
+{
+    uint32_t value = ctrl_flags;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::SOUND_CTRL, data, 4);
+}
+
+void RadiaCode::setVibroCtrl(CTRL ctrl_flags)
+{
+    // Check if CLICKS flag is set, which is not supported for vibro
+    if (ctrl_flags & CTRL::CLICKS)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: CTRL::CLICKS not supported for vibro");
+#endif
+        return;
+    }
+    // Check if CONNECTION flag is set, which is not supported for vibro
+    if (ctrl_flags & CTRL::CONNECTION)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: CTRL::CONNECTION not supported for vibro");
+#endif
+        return;
+    }
+    // Check if POWER flag is set, which is not supported for vibro
+    if (ctrl_flags & CTRL::POWER)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: CTRL::POWER not supported for vibro");
+#endif
+        return;
+    }
+
+    uint32_t value = ctrl_flags;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::VIBRO_CTRL, data, 4);
+}
+
+void RadiaCode::setDisplayOffTime(uint8_t seconds)
+{
+    if ((seconds != 5) && (seconds != 10) && (seconds != 15) && (seconds != 30))
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Display off time must be 5, 10, 15, or 30 seconds");
+#endif
+        return;
+    }
+
+    uint32_t value = (seconds == 30) ? 3 : ((seconds / 5) - 1);
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::DISP_OFF_TIME, data, 4);
+}
+
+void RadiaCode::setDisplayBrightness(uint8_t brightness)
+{
+    if (brightness > 9)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: Brightness must be between 0 and 9");
+#endif
+        return;
+    }
+
+    uint32_t value = brightness;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::DISP_BRT, data, 4);
+}
+
+void RadiaCode::setDisplayDirection(DisplayDirection direction)
+{
+    uint32_t value = direction;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::DISP_DIR, data, 4);
+}
+
+void RadiaCode::setDisplayCtrl(DISPLAY_CTRL ctrl_flags)
+{
+    uint32_t value = ctrl_flags;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::DISP_CTRL, data, 4);
+}
+
+void RadiaCode::setMeasurementUnit(MeasurementUnits unit)
+{
+    uint32_t value = unit;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::DS_UNITS, data, 4);
+}
+
+void RadiaCode::setCountRateUnit(CountRateUnits unit)
+{
+    uint32_t value = unit;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::CR_UNITS, data, 4);
+}
+
+void RadiaCode::setTemperatureUnit(TemperatureUnits unit)
+{
+    uint32_t value = unit;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::TEMP_UNITS, data, 4);
+}
+
+void RadiaCode::setAlarmSignalMode(AlarmSignalMode mode)
+{
+    uint32_t value = mode;
+    uint8_t data[4];
+    memcpy(data, &value, 4);
+
+    writeRequest(VSFR::ALARM_MODE, data, 4);
+}
+
+AlarmLimits RadiaCode::getAlarmLimits(void)
+{
+    std::vector<uint32_t> regs =
+    {
+        VSFR::CR_LEV1_cp10s,
+        VSFR::CR_LEV2_cp10s,
+        VSFR::DR_LEV1_uR_h,
+        VSFR::DR_LEV2_uR_h,
+        VSFR::DS_LEV1_uR,
+        VSFR::DS_LEV2_uR,
+        VSFR::DS_UNITS,
+        VSFR::CR_UNITS
+    };
+
+    std::vector<float> resp = batchReadVSFRs(regs);
+
+    AlarmLimits limits;
+
+    if (resp.size() >= 8)
+    {
+        float dose_multiplier = resp[6] ? 100.0f : 1.0f;
+        float count_multiplier = resp[7] ? 60.0f : 1.0f;
+
+        limits.l1_count_rate = resp[0] / 10.0f * count_multiplier;
+        limits.l2_count_rate = resp[1] / 10.0f * count_multiplier;
+        limits.l1_dose_rate = resp[2] / dose_multiplier;
+        limits.l2_dose_rate = resp[3] / dose_multiplier;
+        limits.l1_dose = resp[4] / 1.0e6f / dose_multiplier;
+        limits.l2_dose = resp[5] / 1.0e6f / dose_multiplier;
+        limits.dose_unit = resp[6] ? "Sv" : "R";
+        limits.count_unit = resp[7] ? "cpm" : "cps";
+    }
+
+    return limits;
+}
+
+bool RadiaCode::setAlarmLimits(
+    float l1_count_rate, 
+    float l2_count_rate,
+    float l1_dose_rate, 
+    float l2_dose_rate,
+    float l1_dose, 
+    float l2_dose,
+    bool dose_unit_sv, 
+    bool count_unit_cpm)
+{
+    std::vector<uint32_t> which_limits;
+    std::vector<uint32_t> limit_values;
+
+    float dose_multiplier = dose_unit_sv ? 100.0f : 1.0f;
+    float count_multiplier = count_unit_cpm ? 1.0f / 6.0f : 10.0f;
+
+    if (l1_count_rate >= 0.0f)
+    {
+        which_limits.push_back(VSFR::CR_LEV1_cp10s);
+        limit_values.push_back((uint32_t)round(l1_count_rate * count_multiplier));
+    }
+
+    if (l2_count_rate >= 0.0f)
+    {
+        which_limits.push_back(VSFR::CR_LEV2_cp10s);
+        limit_values.push_back((uint32_t)round(l2_count_rate * count_multiplier));
+    }
+
+    if (l1_dose_rate >= 0.0f)
+    {
+        which_limits.push_back(VSFR::DR_LEV1_uR_h);
+        limit_values.push_back((uint32_t)round(l1_dose_rate * dose_multiplier));
+    }
+
+    if (l2_dose_rate >= 0.0f)
+    {
+        which_limits.push_back(VSFR::DR_LEV2_uR_h);
+        limit_values.push_back((uint32_t)round(l2_dose_rate * dose_multiplier));
+    }
+
+    if (l1_dose >= 0.0f)
+    {
+        which_limits.push_back(VSFR::DS_LEV1_uR);
+        limit_values.push_back((uint32_t)round(l1_dose * 1.0e6f * dose_multiplier));
+    }
+
+    if (l2_dose >= 0.0f)
+    {
+        which_limits.push_back(VSFR::DS_LEV2_uR);
+        limit_values.push_back((uint32_t)round(l2_dose * 1.0e6f * dose_multiplier));
+    }
+
+    size_t num_to_set = which_limits.size();
+    if (num_to_set == 0)
+    {
+#ifdef RC_DEBUG_ERROR
+        Serial.println("Error: No limits specified");
+#endif
+        return false;
+    }
+
+    which_limits.push_back(VSFR::DS_UNITS);
+    limit_values.push_back((uint32_t)(dose_unit_sv ? 1 : 0));
+
+    which_limits.push_back(VSFR::CR_UNITS);
+    limit_values.push_back((uint32_t)(count_unit_cpm ? 1 : 0));
+
+    num_to_set = which_limits.size();
+
+    // Create message on the stack; at most eight registers are ever set here
+    uint8_t msg[4 + 8 * 4 * 2]; // 4 bytes for count, 4 bytes per ID and value
+    size_t msg_size = 4 + num_to_set * 4 * 2;
+
+    // Add count
+    uint32_t count = num_to_set;
+    memcpy(msg, &count, 4);
+
+    // Add IDs
+    for (size_t i = 0; i < num_to_set; i++)
+    {
+        uint32_t id = which_limits[i];
+        memcpy(msg + 4 + i * 4, &id, 4);
+    }
+
+    // Add values
+    for (size_t i = 0; i < num_to_set; i++)
+    {
+        uint32_t value = limit_values[i];
+        memcpy(msg + 4 + num_to_set * 4 + i * 4, &value, 4);
+    }
+
+    // Every register in this batch may change; drop the cached readings
+    // before the write so a failed response cannot leave stale entries
+    for (size_t i = 0; i < num_to_set; i++)
+    {
+        vsfrCacheInvalidate(which_limits[i]);
+    }
+
+    // Send request
+    BytesBuffer resp = execute(COMMAND::WR_VIRT_SFR_BATCH, msg, msg_size);
+
+    // Check response
+    uint32_t result;
+    resp.readUint32(&result);
+
+    uint32_t expected_valid = (1 << num_to_set) - 1;
+    return expected_valid == result;
+}
@@ -32,6 +32,11 @@
 #include "RadiaCodeTypes.h"
 #include "RadiaCodeTransport.h"
 
+#if defined(ARDUINO_ARCH_ESP32)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
 // Driver version
 #define DRIVER_VERSION_MAJOR 1
 #define DRIVER_VERSION_MINOR 0
@@ -48,6 +53,13 @@ class RadiaCode
     public:
         // Constructor and Destructor
         RadiaCode(const char* bluetooth_mac = nullptr, bool ignore_firmware_compatibility_check = false);
+
+        // Wired constructor: talks to a cradled detector over an already
+        // opened serial Stream (hardware UART to the USB bridge, or native
+        // USB CDC) instead of BLE. Everything above the transport behaves
+        // identically; the wire just answers in milliseconds.
+        RadiaCode(Stream& serial, bool ignore_firmware_compatibility_check = false);
+
         ~RadiaCode(void);
 
         // Device information methods
@@ -60,6 +72,19 @@ class RadiaCode
         String textMessage(void);
         String commands(void);
 
+        // Allocation-free variants of the device information methods above:
+        // results land in caller-provided storage instead of heap-allocated
+        // Strings, so a supervisor task can poll device identity on every
+        // reconnect without fragmenting the heap. The char-buffer variants
+        // always NUL-terminate (truncating to fit) and return the number of
+        // characters written, 0 on failure. fwVersion() fills a FwVersion
+        // struct and returns false on failure.
+        bool fwVersion(FwVersion& version_out);
+        size_t fwSignature(char* buffer, size_t buffer_size);
+        size_t serialNumber(char* buffer, size_t buffer_size);
+        size_t configuration(char* buffer, size_t buffer_size);
+        size_t textMessage(char* buffer, size_t buffer_size);
+
         // Time and configuration methods
         void setLocalTime(uint8_t day, uint8_t month, uint16_t year, uint8_t second, uint8_t minute, uint8_t hour);
         void deviceTime(uint32_t v);
@@ -68,6 +93,102 @@ class RadiaCode
         std::vector<DataItem*> dataBuf(void);
         Spectrum spectrum(void);
         Spectrum spectrumAccum(void);
+        Spectrum spectrumDiff(void);
+
+        // Cached accumulated spectrum: the first call fetches the full
+        // SPEC_ACCUM snapshot, later calls transfer only the SPEC_DIFF
+        // delta and merge it into the cached totals, cutting the ~4 KB
+        // re-transfer per poll to the changed channels. The cached header
+        // metadata (duration) reflects the last full fetch; the counts are
+        // kept current. Invalidated by spectrumReset().
+        Spectrum spectrumAccumCached(void);
+
+        // Allocation-free data acquisition: decodes into a driver-owned
+        // DataItemPool instead of heap-allocated items. Returns the number of
+        // items decoded; walk them via dataPool().itemAt(i). The pool is reset
+        // on the next call, so items must be consumed before then.
+        size_t dataBufPooled(void);
+        DataItemPool& dataPool(void);
+
+        // Flat-record data acquisition: fills a caller-provided array of
+        // tagged-union DataItemRecord values. Contiguous and allocation-free,
+        // so iterating every record each poll costs no pointer chasing.
+        size_t dataBuf(DataItemRecord* records, size_t max_records);
+
+        // Streaming methods (ESP32 only)
+        // startStreaming() launches a background task that polls DATA_BUF at
+        // the given cadence and deposits decoded records into a lock-free
+        // single-producer/single-consumer ring; the application drains it
+        // with readStream() whenever convenient. When the ring fills, the
+        // oldest records are overwritten and streamDropped() counts them.
+        // While streaming is active the background task owns the BLE link,
+        // so other blocking methods on this object should not be called
+        // concurrently from the application.
+        bool startStreaming(uint32_t poll_interval_ms = 1000);
+
+        // Adaptive variant: the poll interval floats between the given
+        // bounds based on how much each poll yields. Polls that come back
+        // near empty back the cadence off toward max_interval_ms; full
+        // batches tighten it toward min_interval_ms. This keeps BLE airtime
+        // proportional to the actual data rate - quiet devices cost almost
+        // no radio time, activity spikes are drained before the device-side
+        // buffer overflows.
+        bool startStreaming(uint32_t min_interval_ms, uint32_t max_interval_ms);
+
+        // Current poll interval: the fixed cadence, or the adaptive
+        // scheduler's latest choice
+        uint32_t streamInterval(void);
+
+        void stopStreaming(void);
+        bool streamingActive(void);
+        size_t readStream(DataItemRecord* records, size_t max_records);
+        size_t streamAvailable(void);
+        uint32_t streamDropped(void);
+
+        // Asynchronous data acquisition methods
+        // Submit a request with one of the *Async() starters, keep loop()
+        // running, poll asyncReady() and collect the result with the matching
+        // *AsyncResult() method. Only one async request can be in flight at a
+        // time; on transports without async support the starters return false
+        // and the blocking methods above remain available.
+        bool spectrumAsync(void);
+        bool spectrumAccumAsync(void);
+        bool dataBufAsync(void);
+        bool asyncPending(void);
+        bool asyncReady(void);
+        bool spectrumAsyncResult(Spectrum& spectrum_out);
+        std::vector<DataItem*> dataBufAsyncResult(void);
+
+        // Double-buffered spectrum prefetch, built on the async machinery
+        // above. While the application processes one driver-owned Spectrum
+        // the next fetch is already in flight into the other, so BLE
+        // transfer time overlaps processing time instead of adding to it.
+        // spectrumSwap() waits for the in-flight fetch (instant when
+        // processing took longer than the transfer), hands over the fresh
+        // buffer and immediately starts the next fetch; the returned
+        // Spectrum stays valid until the next swap. Returns nullptr on
+        // timeout or a bad frame - the prefetch pipeline recovers on the
+        // next call. Requires a transport with async support; while
+        // prefetch is active the other *Async() starters must not be used.
+        bool startSpectrumPrefetch(void);
+        const Spectrum* spectrumSwap(uint32_t timeout_ms = 30000);
+        void stopSpectrumPrefetch(void);
+        bool spectrumPrefetchActive(void);
+
+        // Pipelined DATA_BUF polling, on transports with a pipelined mode
+        // (BLE on ESP32). startPipelinedDataBuf() brings up the transport
+        // service task and puts the first poll on the air; each
+        // dataBufPipelined() call collects the completed response, submits
+        // the next poll before decoding, and then decodes into the given
+        // record array - so the radio exchange for poll N+1 overlaps the
+        // decode of poll N. Returns the number of records decoded, 0 on
+        // timeout or when the pipeline is not running. While active the
+        // service task owns the link, so the blocking methods on this
+        // object must not be called concurrently.
+        bool startPipelinedDataBuf(void);
+        size_t dataBufPipelined(DataItemRecord* records, size_t max_records, uint32_t timeout_ms = 5000);
+        void stopPipelinedDataBuf(void);
+        bool pipelinedDataBufActive(void);
 
         // Reset methods
         void doseReset(void);
@@ -77,9 +198,31 @@ class RadiaCode
         std::vector<float> energyCalib(void);
         void setEnergyCalib(float a0, float a1, float a2);
 
+        // Per-channel energy lookup table built from the current calibration
+        // coefficients. Rebuilt lazily: the table refreshes itself from the
+        // most recently fetched spectrum (a no-op while the coefficients are
+        // unchanged) and is invalidated by setEnergyCalib(). If no spectrum
+        // has been fetched yet, the accessor reads the coefficients from the
+        // device first.
+        EnergyCalibLUT& energyCalibLUT(void);
+
         // Debug methods
         uint8_t getSpectrumFormatVersion(void);
 
+        // Settings transaction methods
+        // Between beginSettingsTransaction() and commitSettingsTransaction()
+        // the 4-byte VSFR setters below (setSoundOn, setDisplayBrightness,
+        // ...) are staged locally instead of each costing a full BLE round
+        // trip; commit flushes every staged write in a single
+        // WR_VIRT_SFR_BATCH command, mirroring batchReadVSFRs() on the read
+        // side. Staging the same register twice keeps the last value. If more
+        // writes are staged than fit in one batch, the full batch is flushed
+        // early so nothing is lost.
+        void beginSettingsTransaction(void);
+        bool commitSettingsTransaction(void);
+        void abortSettingsTransaction(void);
+        bool settingsTransactionActive(void);
+
         // Device settings methods
         void setLanguage(const char* lang);
         void setDeviceOn(bool on);
@@ -97,6 +240,12 @@ class RadiaCode
         void setCountRateUnit(CountRateUnits unit);
         void setTemperatureUnit(TemperatureUnits unit);
 
+        // On-host alarm engine: configure thresholds and a callback on the
+        // returned monitor and every RealTimeData/DoseRateDB record is
+        // evaluated inline during DATA_BUF decoding (all dataBuf variants
+        // and the streaming mode), firing within the same poll cycle
+        AlarmMonitor& alarmMonitor(void);
+
         // Alarm methods
         void setAlarmSignalMode(AlarmSignalMode mode);
         AlarmLimits getAlarmLimits(void);
@@ -115,18 +264,142 @@ class RadiaCode
 
     private:
         // Low-level communication methods
+        // Assemble a framed request (length prefix, command header with
+        // the next sequence number, args) into _frame_buffer; returns the
+        // total frame size, 0 when the args exceed the fixed buffer
+        size_t buildFrame(COMMAND reqtype, const uint8_t* args, size_t args_len);
         BytesBuffer execute(COMMAND reqtype, const uint8_t* args = nullptr, size_t args_len = 0);
+        bool executeAsync(COMMAND reqtype, const uint8_t* args = nullptr, size_t args_len = 0);
         BytesBuffer readRequest(uint32_t command_id);
+        bool readRequestAsync(uint32_t command_id);
+        BytesBuffer asyncResponse(void);
+        bool validateReadResponse(BytesBuffer& r, uint32_t command_id);
         void writeRequest(uint32_t command_id, const uint8_t* data = nullptr, size_t data_len = 0);
         std::vector<float> batchReadVSFRs(const std::vector<uint32_t>& vsfr_ids);
         uint32_t readVSFR(uint32_t vsfr_id);
 
+        // Settings transaction helpers
+        void stageVSFRWrite(uint32_t vsfr_id, uint32_t value);
+        bool flushStagedWrites(void);
+
+        // VSFR read cache helpers (see the cache members below)
+        static uint32_t vsfrCacheTTL(uint32_t vsfr_id);
+        bool vsfrCacheLookup(uint32_t vsfr_id, uint32_t& value_out);
+        void vsfrCacheStore(uint32_t vsfr_id, uint32_t value);
+        void vsfrCacheInvalidate(uint32_t vsfr_id);
+        static float convertVSFRValue(uint32_t vsfr_id, uint32_t raw_value);
+
+        // Shared by the constructors: zero the members, then bring up the
+        // device over whatever transport the constructor installed
+        void initMembers(void);
+        void initDevice(bool ignore_firmware_compatibility_check);
+
         // Variables
         RadiaCodeTransport* _connection;
         uint8_t _seq;
         bool _bt_supported;
         uint32_t _base_time_sec;
         uint8_t _spectrum_format_version;
+
+        // Async request bookkeeping
+        bool _async_pending;
+        uint32_t _async_command_id;
+        uint8_t _async_req_header[4];
+
+        // Fixed frame-assembly storage for the command path. Every command
+        // is small and bounded (the largest is a full batched VSFR write),
+        // so execute()/executeAsync() build the length prefix, header and
+        // args in place here instead of heap-allocating two scratch buffers
+        // per command. The transport copies the frame before returning, so
+        // the buffer is free again by the time the next command runs.
+        static const size_t MAX_REQUEST_ARGS = 256;
+        uint8_t _frame_buffer[MAX_REQUEST_ARGS + 8];
+
+        // Pool for allocation-free DATA_BUF decoding
+        DataItemPool _data_pool;
+
+        // Settings transaction staging. Fixed-capacity tables keep staging
+        // allocation-free; 16 slots comfortably covers a full provisioning
+        // pass over the available setters.
+        static const size_t MAX_STAGED_WRITES = 16;
+        bool _txn_active;
+        size_t _txn_count;
+        uint32_t _txn_ids[MAX_STAGED_WRITES];
+        uint32_t _txn_values[MAX_STAGED_WRITES];
+
+        // VSFR read cache. Settings and calibration registers never change
+        // behind the driver's back, so readVSFR()/batchReadVSFRs() serve
+        // them from here until one of our own writes invalidates the entry;
+        // volatile registers like TEMP_degC get a short TTL instead. UI
+        // code polling getTemperature()/getAlarmLimits()/energyCalib() on
+        // every redraw then costs a BLE round trip only when an answer is
+        // genuinely stale. The slot count covers every cacheable register;
+        // registers with a VSFR_TTL_NONE policy are never stored.
+        static const size_t VSFR_CACHE_SLOTS = 32;
+        static const uint32_t VSFR_TTL_NONE = 0;
+        static const uint32_t VSFR_TTL_STATIC = 0xFFFFFFFF;
+        static const uint32_t VSFR_TTL_TEMP_MS = 1000;
+        size_t _vsfr_cache_count;
+        uint32_t _vsfr_cache_ids[VSFR_CACHE_SLOTS];
+        uint32_t _vsfr_cache_values[VSFR_CACHE_SLOTS];
+        uint32_t _vsfr_cache_times[VSFR_CACHE_SLOTS];
+
+        // Per-instance spectrum state: a scratch object reused by the
+        // blocking fetch methods and the locally held accumulation for
+        // differential fetches
+        Spectrum _spectrum_scratch;
+        Spectrum _diff_accum;
+        bool _diff_seeded;
+
+        // Locally maintained accumulated spectrum (see spectrumAccumCached)
+        Spectrum _accum_cache;
+        bool _accum_seeded;
+
+        // Double-buffered prefetch state (see startSpectrumPrefetch): the
+        // application reads the front buffer while the in-flight fetch
+        // lands in the other
+        Spectrum _prefetch_spectra[2];
+        uint8_t _prefetch_front;
+        bool _prefetch_active;
+
+        // Pipelined DATA_BUF polling state (see startPipelinedDataBuf)
+        bool _pipelined_databuf_active;
+
+        // Fetch the next SPEC_DIFF delta and merge it into every seeded
+        // spectrum cache, so one delta stream serves both views
+        bool fetchSpectrumDelta(void);
+
+        // Cached per-channel energy table (see energyCalibLUT)
+        EnergyCalibLUT _energy_lut;
+
+        // Inline alarm engine fed by the DATA_BUF decoders (see alarmMonitor)
+        AlarmMonitor _alarm_monitor;
+
+#if defined(ARDUINO_ARCH_ESP32)
+        // Streaming state (see startStreaming). The ring is indexed with
+        // free-running counters, each with exactly one writer: head by the
+        // polling task, tail and the drop counter by the consumer. The
+        // producer overwrites the oldest slots when the ring is full;
+        // readStream() detects being lapped from the head distance, skips
+        // the overwritten records (counting them as dropped) and re-checks
+        // the distance after each copy to discard a torn record. Ring and
+        // scratch storage exist only while streaming runs.
+        static const size_t STREAM_RING_SIZE = 128; // Power of two
+        static const size_t STREAM_SCRATCH_SIZE = 64;
+        DataItemRecord* _stream_ring;
+        DataItemRecord* _stream_scratch;
+        volatile uint32_t _stream_head;
+        volatile uint32_t _stream_tail;
+        volatile uint32_t _stream_dropped;
+        volatile uint32_t _stream_interval_ms; // Written by the polling task when adaptive
+        uint32_t _stream_min_interval_ms;
+        uint32_t _stream_max_interval_ms;
+        TaskHandle_t _stream_task;
+        volatile bool _stream_run;
+
+        static void streamTaskEntry(void* param);
+        void streamTaskLoop(void);
+#endif
 };
 
 #endif
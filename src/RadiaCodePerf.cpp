@@ -0,0 +1,165 @@
+/**********************************************************************************/
+/* Copyright (c) 2025 Markus Geiger                                               */
+/*                                                                                */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
+/* of this software and associated documentation files (the "Software"), to deal  */
+/* in the Software without restriction, including without limitation the rights   */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
+/* copies of the Software, and to permit persons to whom the Software is          */
+/* furnished to do so, subject to the following conditions:                       */
+/*                                                                                */
+/* The above copyright notice and this permission notice shall be included in all */
+/* copies or substantial portions of the Software.                                */
+/*                                                                                */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
+/* SOFTWARE.                                                                      */
+/**********************************************************************************/
+
+#include "RadiaCodePerf.h"
+
+// Static storage
+bool RadiaCodePerf::_enabled = false;
+PerfStats RadiaCodePerf::_phases[PERF_PHASE_COUNT];
+uint16_t RadiaCodePerf::_command_ids[RadiaCodePerf::MAX_COMMAND_SLOTS];
+PerfStats RadiaCodePerf::_commands[RadiaCodePerf::MAX_COMMAND_SLOTS];
+size_t RadiaCodePerf::_command_count = 0;
+
+void PerfStats::reset(void)
+{
+    count = 0;
+    min_us = 0;
+    max_us = 0;
+    total_us = 0;
+}
+
+void PerfStats::record(uint32_t elapsed_us)
+{
+    if ((count == 0) || (elapsed_us < min_us))
+    {
+        min_us = elapsed_us;
+    }
+    if (elapsed_us > max_us)
+    {
+        max_us = elapsed_us;
+    }
+    total_us += elapsed_us;
+    count++;
+}
+
+uint32_t PerfStats::mean_us(void) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    return (uint32_t)(total_us / count);
+}
+
+void RadiaCodePerf::setEnabled(bool enabled)
+{
+    if (enabled && !_enabled)
+    {
+        // Start from a clean slate so stale samples from an earlier
+        // collection window do not skew the new one
+        reset();
+    }
+    _enabled = enabled;
+}
+
+bool RadiaCodePerf::enabled(void)
+{
+    return _enabled;
+}
+
+void RadiaCodePerf::reset(void)
+{
+    for (size_t i = 0; i < PERF_PHASE_COUNT; i++)
+    {
+        _phases[i].reset();
+    }
+    _command_count = 0;
+}
+
+void RadiaCodePerf::record(PerfPhase phase, uint32_t elapsed_us)
+{
+    if (!_enabled || (phase >= PERF_PHASE_COUNT))
+    {
+        return;
+    }
+    _phases[phase].record(elapsed_us);
+}
+
+void RadiaCodePerf::recordCommand(uint16_t command, uint32_t elapsed_us)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    // Linear scan: the table holds a handful of distinct command types
+    for (size_t i = 0; i < _command_count; i++)
+    {
+        if (_command_ids[i] == command)
+        {
+            _commands[i].record(elapsed_us);
+            return;
+        }
+    }
+
+    if (_command_count >= MAX_COMMAND_SLOTS)
+    {
+        return; // Table full; drop samples for further command types
+    }
+
+    _command_ids[_command_count] = command;
+    _commands[_command_count].reset();
+    _commands[_command_count].record(elapsed_us);
+    _command_count++;
+}
+
+uint32_t RadiaCodePerf::now(void)
+{
+    return (uint32_t)micros();
+}
+
+const PerfStats& RadiaCodePerf::phase(PerfPhase phase_id)
+{
+    static PerfStats empty = {0, 0, 0, 0};
+    if (phase_id >= PERF_PHASE_COUNT)
+    {
+        return empty;
+    }
+    return _phases[phase_id];
+}
+
+bool RadiaCodePerf::commandStats(uint16_t command, PerfStats& stats_out)
+{
+    for (size_t i = 0; i < _command_count; i++)
+    {
+        if (_command_ids[i] == command)
+        {
+            stats_out = _commands[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t RadiaCodePerf::commandCount(void)
+{
+    return _command_count;
+}
+
+uint16_t RadiaCodePerf::commandAt(size_t index)
+{
+    if (index >= _command_count)
+    {
+        return 0;
+    }
+    return _command_ids[index];
+}
@@ -0,0 +1,109 @@
+/**********************************************************************************/
+/* Copyright (c) 2025 Markus Geiger                                               */
+/*                                                                                */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
+/* of this software and associated documentation files (the "Software"), to deal  */
+/* in the Software without restriction, including without limitation the rights   */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
+/* copies of the Software, and to permit persons to whom the Software is          */
+/* furnished to do so, subject to the following conditions:                       */
+/*                                                                                */
+/* The above copyright notice and this permission notice shall be included in all */
+/* copies or substantial portions of the Software.                                */
+/*                                                                                */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
+/* SOFTWARE.                                                                      */
+/**********************************************************************************/
+
+#ifndef RadiaCodePerf_h
+#define RadiaCodePerf_h
+
+#include "Arduino.h"
+
+// Latency instrumentation for the command path. The driver, the transport
+// and the decoders timestamp the boundaries of their phases and feed the
+// elapsed time in here; the accumulated per-phase and per-command-type
+// min/max/mean statistics show where the time between calling spectrum()
+// and getting data actually goes (chunked write, notification wait,
+// decode), without attaching a debugger.
+//
+// Collection is off by default and costs a single branch per phase while
+// disabled. Enable it with RadiaCodePerf::setEnabled(true), let the
+// workload run, then read the stats:
+//
+//     const PerfStats& wait = RadiaCodePerf::phase(PERF_TRANSPORT_WAIT);
+//     Serial.println(wait.mean_us());
+
+// Instrumented phases of one command round trip
+enum PerfPhase
+{
+    PERF_EXECUTE = 0,        // RadiaCode::execute(), end to end
+    PERF_TRANSPORT_WRITE,    // Chunked write of the request over BLE
+    PERF_TRANSPORT_WAIT,     // Wait for the reassembled response
+    PERF_DECODE_SPECTRUM,    // Buffered decodeSpectrum()
+    PERF_DECODE_DATABUF,     // decodeDataBuf() (all variants)
+    PERF_PHASE_COUNT
+};
+
+// Accumulated timing statistics for one phase or command type
+struct PerfStats
+{
+    uint32_t count;    // Samples recorded
+    uint32_t min_us;   // Shortest sample
+    uint32_t max_us;   // Longest sample
+    uint64_t total_us; // Sum of all samples
+
+    void reset(void);
+    void record(uint32_t elapsed_us);
+    uint32_t mean_us(void) const;
+};
+
+class RadiaCodePerf
+{
+    public:
+        // Turn collection on or off; disabled recording is a no-op
+        static void setEnabled(bool enabled);
+        static bool enabled(void);
+
+        // Clear all accumulated statistics
+        static void reset(void);
+
+        // Record one sample (called from the instrumented code paths)
+        static void record(PerfPhase phase, uint32_t elapsed_us);
+        static void recordCommand(uint16_t command, uint32_t elapsed_us);
+
+        // Timestamp helper for the instrumented code paths. micros() is
+        // backed by esp_timer on the ESP32, giving microsecond resolution;
+        // only differences are used, so the rollover does not matter.
+        static uint32_t now(void);
+
+        // Accumulated statistics per phase
+        static const PerfStats& phase(PerfPhase phase_id);
+
+        // Accumulated statistics per command type (the COMMAND enum value).
+        // Returns false if the command has not been recorded yet.
+        static bool commandStats(uint16_t command, PerfStats& stats_out);
+
+        // Walk the recorded command types (for dumping all of them):
+        // slots 0..commandCount()-1 are valid
+        static size_t commandCount(void);
+        static uint16_t commandAt(size_t index);
+
+    private:
+        // Distinct command types seen in practice: a handful of reads and
+        // writes; 12 slots leave headroom
+        static const size_t MAX_COMMAND_SLOTS = 12;
+
+        static bool _enabled;
+        static PerfStats _phases[PERF_PHASE_COUNT];
+        static uint16_t _command_ids[MAX_COMMAND_SLOTS];
+        static PerfStats _commands[MAX_COMMAND_SLOTS];
+        static size_t _command_count;
+};
+
+#endif
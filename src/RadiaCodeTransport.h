@@ -30,6 +30,37 @@ class RadiaCodeTransport
     public:
         virtual ~RadiaCodeTransport(void) {}
         virtual BytesBuffer execute(const uint8_t* request, size_t length) = 0;
+
+        // Optional asynchronous interface. Transports that can receive in the
+        // background (e.g. via BLE notifications) override these so callers can
+        // submit a request and keep running while the response is in flight.
+        // The default implementation reports "not supported" and callers fall
+        // back to the blocking execute() path.
+        virtual bool executeAsync(const uint8_t* request, size_t length) { return false; }
+        virtual bool responseReady(void) { return false; }
+        virtual BytesBuffer takeResponse(void) { return BytesBuffer(); }
+
+        // Optional pipelined interface. Transports with their own service
+        // task override these: pipelineSubmit() queues a framed request for
+        // the transport task to send, and pipelineReceive() blocks (up to
+        // timeout_ms) for the next completed response, handed over as a
+        // read-only view. This lets radio wait time on one core overlap
+        // decoding of the previous response on another. The defaults report
+        // "not supported" so callers fall back to execute().
+        virtual bool startPipeline(void) { return false; }
+        virtual void stopPipeline(void) {}
+        virtual bool pipelineSubmit(const uint8_t* request, size_t length) { return false; }
+        virtual bool pipelineReceive(BytesBuffer& response_out, uint32_t timeout_ms) { return false; }
+
+        // Optional raw fragment tee for streaming decoders. When a sink is
+        // set, every received fragment - including the length prefix and
+        // response header - is also handed to the callback as it arrives,
+        // before reassembly completes. The callback runs in the transport's
+        // receive context, so it must be quick and touch only state the
+        // blocked caller owns. Pass nullptr to clear. The default ignores
+        // the sink; such transports simply never deliver fragments early.
+        typedef void (*FragmentCallback)(void* ctx, const uint8_t* data, size_t length);
+        virtual void setFragmentSink(FragmentCallback callback, void* ctx) { (void)callback; (void)ctx; }
 };
 
 #endif
@@ -1,170 +1,529 @@
-/**********************************************************************************/
-/* Copyright (c) 2025 Markus Geiger                                               */
-/*                                                                                */
-/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
-/* of this software and associated documentation files (the "Software"), to deal  */
-/* in the Software without restriction, including without limitation the rights   */
-/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
-/* copies of the Software, and to permit persons to whom the Software is          */
-/* furnished to do so, subject to the following conditions:                       */
-/*                                                                                */
-/* The above copyright notice and this permission notice shall be included in all */
-/* copies or substantial portions of the Software.                                */
-/*                                                                                */
-/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
-/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
-/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
-/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
-/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
-/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
-/* SOFTWARE.                                                                      */
-/**********************************************************************************/
-
-#include "RadiaCodeTypes.h"
-
-// Debugging switches
-#define RCTYPES_DEBUG_WARNING
-
-// Define the static shared buffer for the Spectrum class
-// This moves the large array out of the stack and into static memory
-uint32_t Spectrum::shared_counts[Spectrum::MAX_CHANNELS] = {0};
-
-// Constructor
-Spectrum::Spectrum(void) : duration_sec(0), a0(0), a1(0), a2(0), count_size(0)
-{
-    // Use the shared static buffer
-    counts = shared_counts;
-    // Zero out only the part of the array we'll use
-    memset(counts, 0, sizeof(uint32_t) * MAX_CHANNELS);
-}
-
-// Destructor - nothing to do with fixed arrays
-Spectrum::~Spectrum(void)
-{
-    // No cleanup needed for fixed arrays
-}
-
-// Copy constructor
-Spectrum::Spectrum(const Spectrum& other) : 
-    duration_sec(other.duration_sec), 
-    a0(other.a0),
-    a1(other.a1),
-    a2(other.a2),
-    count_size(0)
-{
-    // Initialize to 0 first for safety
-
-    // Use the shared buffer
-    counts = shared_counts;
-
-    // Make sure the source count_size is valid
-    size_t safe_count = other.count_size;
-    if (safe_count > MAX_CHANNELS)
-    {
-#ifdef RCTYPES_DEBUG_WARNING
-        Serial.println("Warning: Copy constructor truncating spectrum data");
-#endif
-        safe_count = MAX_CHANNELS;
-    }
-
-    // Set the count_size after validation
-    count_size = safe_count;
-
-    // Safe memcpy with validated size
-    if ((count_size > 0) && (other.counts != nullptr))
-    {
-        memcpy(counts, other.counts, count_size * sizeof(uint32_t));
-    }
-}
-
-// Assignment operator
-Spectrum& Spectrum::operator=(const Spectrum& other)
-{
-    if (this != &other)
-    {
-        duration_sec = other.duration_sec;
-        a0 = other.a0;
-        a1 = other.a1;
-        a2 = other.a2;
-
-        // Ensure we're using the shared buffer
-        counts = shared_counts;
-
-        // Make sure the source count_size is valid
-        size_t safe_count = other.count_size;
-        if (safe_count > MAX_CHANNELS)
-        {
-#ifdef RCTYPES_DEBUG_WARNING
-            Serial.println("Warning: Assignment operator truncating spectrum data");
-#endif
-            safe_count = MAX_CHANNELS;
-        }
-
-        // Set the count_size after validation
-        count_size = safe_count;
-
-        // Safe memcpy with validated size
-        if ((count_size > 0) && (other.counts != nullptr))
-        {
-            memcpy(counts, other.counts, count_size * sizeof(uint32_t));
-        }
-    }
-    return *this;
-}
-
-// Clear method - just reset the size
-void Spectrum::clear(void)
-{
-    duration_sec = 0;
-    a0 = 0;
-    a1 = 0;
-    a2 = 0;
-    count_size = 0;
-
-    // Ensure we're using the shared buffer
-    counts = shared_counts;
-
-    // We'll zero out just the first few elements for safety
-    // Full zeroing is not needed since we track the count_size
-    memset(counts, 0, sizeof(uint32_t) * 16);  // Zero first 16 elements
-}
-
-// Vector-like interface methods for compatibility
-size_t Spectrum::size(void) const
-{
-    return count_size;
-}
-
-bool Spectrum::empty(void) const
-{
-    return count_size == 0;
-}
-
-void Spectrum::push_back(uint32_t value)
-{
-    if (count_size < MAX_CHANNELS)
-    {
-        counts[count_size++] = value;
-    }
-    else
-    {
-        // Only print the warning once to avoid flooding Serial
-        static bool warning_printed = false;
-        if (!warning_printed)
-        {
-#ifdef RCTYPES_DEBUG_WARNING
-            Serial.println("Warning: Spectrum array full, ignoring additional data");
-#endif
-            warning_printed = true;
-        }
-    }
-}
-
-uint32_t Spectrum::at(size_t index) const
-{
-    if (index < count_size)
-    {
-        return counts[index];
-    }
-    return 0; // Safety fallback
-}
+/**********************************************************************************/
+/* Copyright (c) 2025 Markus Geiger                                               */
+/*                                                                                */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
+/* of this software and associated documentation files (the "Software"), to deal  */
+/* in the Software without restriction, including without limitation the rights   */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
+/* copies of the Software, and to permit persons to whom the Software is          */
+/* furnished to do so, subject to the following conditions:                       */
+/*                                                                                */
+/* The above copyright notice and this permission notice shall be included in all */
+/* copies or substantial portions of the Software.                                */
+/*                                                                                */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
+/* SOFTWARE.                                                                      */
+/**********************************************************************************/
+
+#include "RadiaCodeTypes.h"
+#include <new> // For placement new in DataItemPool
+
+// Debugging switches
+#define RCTYPES_DEBUG_WARNING
+
+DataItemPool::DataItemPool(void) : _used(0)
+{
+    memset(_items, 0, sizeof(_items));
+}
+
+DataItemPool::~DataItemPool(void)
+{
+    reset();
+}
+
+void* DataItemPool::allocSlot(void)
+{
+    if (_used >= MAX_ITEMS)
+    {
+#ifdef RCTYPES_DEBUG_WARNING
+        // Only print the warning once per exhaustion to avoid flooding Serial
+        static bool warning_printed = false;
+        if (!warning_printed)
+        {
+            Serial.println("Warning: DataItemPool exhausted, dropping items");
+            warning_printed = true;
+        }
+#endif
+        return nullptr;
+    }
+
+    return (void*)(_storage + _used * SLOT_SIZE);
+}
+
+RealTimeData* DataItemPool::allocRealTimeData(void)
+{
+    void* slot = allocSlot();
+    if (slot == nullptr)
+    {
+        return nullptr;
+    }
+    RealTimeData* item = new (slot) RealTimeData();
+    _items[_used++] = item;
+    return item;
+}
+
+RawData* DataItemPool::allocRawData(void)
+{
+    void* slot = allocSlot();
+    if (slot == nullptr)
+    {
+        return nullptr;
+    }
+    RawData* item = new (slot) RawData();
+    _items[_used++] = item;
+    return item;
+}
+
+DoseRateDB* DataItemPool::allocDoseRateDB(void)
+{
+    void* slot = allocSlot();
+    if (slot == nullptr)
+    {
+        return nullptr;
+    }
+    DoseRateDB* item = new (slot) DoseRateDB();
+    _items[_used++] = item;
+    return item;
+}
+
+RareData* DataItemPool::allocRareData(void)
+{
+    void* slot = allocSlot();
+    if (slot == nullptr)
+    {
+        return nullptr;
+    }
+    RareData* item = new (slot) RareData();
+    _items[_used++] = item;
+    return item;
+}
+
+Event* DataItemPool::allocEvent(void)
+{
+    void* slot = allocSlot();
+    if (slot == nullptr)
+    {
+        return nullptr;
+    }
+    Event* item = new (slot) Event();
+    _items[_used++] = item;
+    return item;
+}
+
+void DataItemPool::reset(void)
+{
+    // Run the destructors in place; the slots themselves are reused
+    for (size_t i = 0; i < _used; i++)
+    {
+        if (_items[i] != nullptr)
+        {
+            _items[i]->~DataItem();
+            _items[i] = nullptr;
+        }
+    }
+    _used = 0;
+}
+
+DataItem* DataItemPool::itemAt(size_t index) const
+{
+    if (index < _used)
+    {
+        return _items[index];
+    }
+    return nullptr; // Safety fallback
+}
+
+size_t DataItemPool::used(void) const
+{
+    return _used;
+}
+
+size_t DataItemPool::capacity(void) const
+{
+    return MAX_ITEMS;
+}
+
+// Constructor
+Spectrum::Spectrum(void) : duration_sec(0), a0(0), a1(0), a2(0), count_size(0)
+{
+    // Per-instance channel array, kept on the heap to stay off the stack
+    counts = new uint32_t[MAX_CHANNELS];
+    memset(counts, 0, sizeof(uint32_t) * MAX_CHANNELS);
+}
+
+// Destructor - releases the per-instance channel array
+Spectrum::~Spectrum(void)
+{
+    if (counts != nullptr)
+    {
+        delete[] counts;
+        counts = nullptr;
+    }
+}
+
+// Copy constructor
+Spectrum::Spectrum(const Spectrum& other) : 
+    duration_sec(other.duration_sec), 
+    a0(other.a0),
+    a1(other.a1),
+    a2(other.a2),
+    count_size(0)
+{
+    // Per-instance channel array for the copy as well
+    counts = new uint32_t[MAX_CHANNELS];
+
+    // Make sure the source count_size is valid
+    size_t safe_count = other.count_size;
+    if (safe_count > MAX_CHANNELS)
+    {
+#ifdef RCTYPES_DEBUG_WARNING
+        Serial.println("Warning: Copy constructor truncating spectrum data");
+#endif
+        safe_count = MAX_CHANNELS;
+    }
+
+    // Set the count_size after validation
+    count_size = safe_count;
+
+    // Safe memcpy with validated size
+    if ((count_size > 0) && (other.counts != nullptr))
+    {
+        memcpy(counts, other.counts, count_size * sizeof(uint32_t));
+    }
+}
+
+// Assignment operator
+Spectrum& Spectrum::operator=(const Spectrum& other)
+{
+    if (this != &other)
+    {
+        duration_sec = other.duration_sec;
+        a0 = other.a0;
+        a1 = other.a1;
+        a2 = other.a2;
+
+        // Make sure the source count_size is valid
+        size_t safe_count = other.count_size;
+        if (safe_count > MAX_CHANNELS)
+        {
+#ifdef RCTYPES_DEBUG_WARNING
+            Serial.println("Warning: Assignment operator truncating spectrum data");
+#endif
+            safe_count = MAX_CHANNELS;
+        }
+
+        // Set the count_size after validation
+        count_size = safe_count;
+
+        // Safe memcpy with validated size
+        if ((count_size > 0) && (other.counts != nullptr))
+        {
+            memcpy(counts, other.counts, count_size * sizeof(uint32_t));
+        }
+    }
+    return *this;
+}
+
+// Clear method - just reset the size
+void Spectrum::clear(void)
+{
+    duration_sec = 0;
+    a0 = 0;
+    a1 = 0;
+    a2 = 0;
+    count_size = 0;
+
+    // We'll zero out just the first few elements for safety
+    // Full zeroing is not needed since we track the count_size
+    memset(counts, 0, sizeof(uint32_t) * 16);  // Zero first 16 elements
+}
+
+// Vector-like interface methods for compatibility
+size_t Spectrum::size(void) const
+{
+    return count_size;
+}
+
+bool Spectrum::empty(void) const
+{
+    return count_size == 0;
+}
+
+void Spectrum::push_back(uint32_t value)
+{
+    if (count_size < MAX_CHANNELS)
+    {
+        counts[count_size++] = value;
+    }
+    else
+    {
+        // Only print the warning once to avoid flooding Serial
+        static bool warning_printed = false;
+        if (!warning_printed)
+        {
+#ifdef RCTYPES_DEBUG_WARNING
+            Serial.println("Warning: Spectrum array full, ignoring additional data");
+#endif
+            warning_printed = true;
+        }
+    }
+}
+
+uint32_t Spectrum::at(size_t index) const
+{
+    if (index < count_size)
+    {
+        return counts[index];
+    }
+    return 0; // Safety fallback
+}
+
+EnergyCalibLUT::EnergyCalibLUT(void)
+{
+    // Heap tables so embedding this object stays cheap on the stack
+    _energy = new float[MAX_CHANNELS];
+    _width = new float[MAX_CHANNELS];
+    _a0 = 0.0f;
+    _a1 = 0.0f;
+    _a2 = 0.0f;
+    _valid = false;
+}
+
+EnergyCalibLUT::~EnergyCalibLUT(void)
+{
+    delete[] _energy;
+    delete[] _width;
+}
+
+// Copy constructor - deep copy so the tables are never shared
+EnergyCalibLUT::EnergyCalibLUT(const EnergyCalibLUT& other)
+{
+    _energy = new float[MAX_CHANNELS];
+    _width = new float[MAX_CHANNELS];
+    _a0 = other._a0;
+    _a1 = other._a1;
+    _a2 = other._a2;
+    _valid = other._valid;
+
+    if (_valid)
+    {
+        memcpy(_energy, other._energy, MAX_CHANNELS * sizeof(float));
+        memcpy(_width, other._width, MAX_CHANNELS * sizeof(float));
+    }
+}
+
+// Assignment operator
+EnergyCalibLUT& EnergyCalibLUT::operator=(const EnergyCalibLUT& other)
+{
+    if (this != &other)
+    {
+        _a0 = other._a0;
+        _a1 = other._a1;
+        _a2 = other._a2;
+        _valid = other._valid;
+
+        if (_valid)
+        {
+            memcpy(_energy, other._energy, MAX_CHANNELS * sizeof(float));
+            memcpy(_width, other._width, MAX_CHANNELS * sizeof(float));
+        }
+    }
+    return *this;
+}
+
+void EnergyCalibLUT::update(float a0, float a1, float a2)
+{
+    // Rebuilding ~2k table entries only pays off because the coefficients
+    // essentially never change; skip the work when they have not
+    if (_valid && (_a0 == a0) && (_a1 == a1) && (_a2 == a2))
+    {
+        return;
+    }
+
+    // Energy at the channel and the span to the next channel:
+    // E(ch) = a0 + a1*ch + a2*ch^2, W(ch) = E(ch+1) - E(ch)
+    for (size_t ch = 0; ch < MAX_CHANNELS; ch++)
+    {
+        float fch = (float)ch;
+        _energy[ch] = a0 + a1 * fch + a2 * fch * fch;
+        _width[ch] = a1 + a2 * (2.0f * fch + 1.0f);
+    }
+
+    _a0 = a0;
+    _a1 = a1;
+    _a2 = a2;
+    _valid = true;
+}
+
+void EnergyCalibLUT::invalidate(void)
+{
+    _valid = false;
+}
+
+bool EnergyCalibLUT::valid(void) const
+{
+    return _valid;
+}
+
+float EnergyCalibLUT::a0(void) const
+{
+    return _a0;
+}
+
+float EnergyCalibLUT::a1(void) const
+{
+    return _a1;
+}
+
+float EnergyCalibLUT::a2(void) const
+{
+    return _a2;
+}
+
+float EnergyCalibLUT::energy(size_t channel) const
+{
+    if (channel < MAX_CHANNELS)
+    {
+        return _energy[channel];
+    }
+    return 0.0f; // Safety fallback
+}
+
+float EnergyCalibLUT::width(size_t channel) const
+{
+    if (channel < MAX_CHANNELS)
+    {
+        return _width[channel];
+    }
+    return 0.0f; // Safety fallback
+}
+
+const float* EnergyCalibLUT::energies(void) const
+{
+    return _energy;
+}
+
+const float* EnergyCalibLUT::widths(void) const
+{
+    return _width;
+}
+
+AlarmMonitor::AlarmMonitor(void)
+{
+    // Negative thresholds mean "not configured"
+    _l1_count_rate = -1.0f;
+    _l2_count_rate = -1.0f;
+    _l1_dose_rate = -1.0f;
+    _l2_dose_rate = -1.0f;
+    _hysteresis = 0.1f;
+    _callback = nullptr;
+    _count_rate_level = ALARM_NONE;
+    _dose_rate_level = ALARM_NONE;
+}
+
+void AlarmMonitor::setLimits(float l1_count_rate, float l2_count_rate, float l1_dose_rate, float l2_dose_rate)
+{
+    _l1_count_rate = l1_count_rate;
+    _l2_count_rate = l2_count_rate;
+    _l1_dose_rate = l1_dose_rate;
+    _l2_dose_rate = l2_dose_rate;
+}
+
+void AlarmMonitor::setLimits(const AlarmLimits& limits)
+{
+    setLimits(limits.l1_count_rate, limits.l2_count_rate, limits.l1_dose_rate, limits.l2_dose_rate);
+}
+
+void AlarmMonitor::setHysteresis(float fraction)
+{
+    // Keep the band sane: 0 disables hysteresis, values near 1 would make
+    // a raised level effectively unclearable
+    if (fraction < 0.0f)
+    {
+        fraction = 0.0f;
+    }
+    if (fraction > 0.9f)
+    {
+        fraction = 0.9f;
+    }
+    _hysteresis = fraction;
+}
+
+void AlarmMonitor::setCallback(AlarmCallback callback)
+{
+    _callback = callback;
+}
+
+bool AlarmMonitor::enabled(void) const
+{
+    return ((_l1_count_rate >= 0.0f) || (_l2_count_rate >= 0.0f) ||
+        (_l1_dose_rate >= 0.0f) || (_l2_dose_rate >= 0.0f));
+}
+
+AlarmLevel AlarmMonitor::classify(float value, float l1, float l2, AlarmLevel current) const
+{
+    // Rising edges use the plain thresholds; a latched level only clears
+    // once the value drops below threshold * (1 - hysteresis)
+    float fall = 1.0f - _hysteresis;
+
+    if ((l2 >= 0.0f) && (value >= ((current >= ALARM_L2) ? (l2 * fall) : l2)))
+    {
+        return ALARM_L2;
+    }
+
+    if ((l1 >= 0.0f) && (value >= ((current >= ALARM_L1) ? (l1 * fall) : l1)))
+    {
+        return ALARM_L1;
+    }
+
+    return ALARM_NONE;
+}
+
+void AlarmMonitor::evaluateCountRate(float count_rate, uint32_t timestamp)
+{
+    AlarmLevel level = classify(count_rate, _l1_count_rate, _l2_count_rate, _count_rate_level);
+
+    if (level != _count_rate_level)
+    {
+        _count_rate_level = level;
+        if (_callback != nullptr)
+        {
+            _callback(ALARM_COUNT_RATE, level, count_rate, timestamp);
+        }
+    }
+}
+
+void AlarmMonitor::evaluateDoseRate(float dose_rate, uint32_t timestamp)
+{
+    AlarmLevel level = classify(dose_rate, _l1_dose_rate, _l2_dose_rate, _dose_rate_level);
+
+    if (level != _dose_rate_level)
+    {
+        _dose_rate_level = level;
+        if (_callback != nullptr)
+        {
+            _callback(ALARM_DOSE_RATE, level, dose_rate, timestamp);
+        }
+    }
+}
+
+AlarmLevel AlarmMonitor::countRateLevel(void) const
+{
+    return _count_rate_level;
+}
+
+AlarmLevel AlarmMonitor::doseRateLevel(void) const
+{
+    return _dose_rate_level;
+}
+
+void AlarmMonitor::reset(void)
+{
+    _count_rate_level = ALARM_NONE;
+    _dose_rate_level = ALARM_NONE;
+}
@@ -26,6 +26,17 @@
 #include "Arduino.h"
 #include <vector>
 
+// Build-time spectrum channel capacity. The device reports up to 1024
+// channels, but memory-constrained deployments that only need coarse
+// spectra can override this from the build flags
+// (e.g. -DRADIACODE_MAX_CHANNELS=256) to shrink the per-Spectrum channel
+// array and the energy lookup tables, and to scale the clear/copy loops
+// with the configured size instead of the worst case. Decoders clamp to
+// this capacity, so a device reporting more channels simply truncates.
+#ifndef RADIACODE_MAX_CHANNELS
+#define RADIACODE_MAX_CHANNELS 1024
+#endif
+
 // Forward declarations
 class BytesBuffer;
 
@@ -42,7 +53,7 @@ enum VS
     SPECTRUM        = 0x200,
     ENERGY_CALIB    = 0x202,
     SPEC_ACCUM      = 0x205,
-    //SPEC_DIFF     = 0x206,   not yet supported !!
+    SPEC_DIFF       = 0x206,
     //SPEC_RESET    = 0x207    not yet supported !!
 };
 
@@ -265,7 +276,8 @@ enum DataItemType
     TYPE_REAL_TIME_DATA = 1,
     TYPE_RAW_DATA       = 2,
     TYPE_DOSE_RATE_DB   = 3,
-    TYPE_RARE_DATA      = 4
+    TYPE_RARE_DATA      = 4,
+    TYPE_EVENT          = 5
 };
 
 class DataItem
@@ -321,11 +333,121 @@ class RareData : public DataItem
 class Event : public DataItem
 {
     public:
+        Event() { type = TYPE_EVENT; }
         EventId event;
         uint8_t event_param1;
         uint16_t flags;
 };
 
+// Flat POD payloads mirroring the DataItem subclasses above. Together with
+// DataItemRecord they give consumers a contiguous, allocation-free
+// representation of a DATA_BUF response: one array of fixed-size records
+// instead of heap-allocated polymorphic objects behind pointers.
+struct RealTimeDataRecord
+{
+    float count_rate;
+    float count_rate_err;
+    float dose_rate;
+    float dose_rate_err;
+    uint16_t flags;
+    uint8_t real_time_flags;
+};
+
+struct RawDataRecord
+{
+    float count_rate;
+    float dose_rate;
+};
+
+struct DoseRateDBRecord
+{
+    uint32_t count;
+    float count_rate;
+    float dose_rate;
+    float dose_rate_err;
+    uint16_t flags;
+};
+
+struct RareDataRecord
+{
+    uint32_t duration;
+    float dose;
+    float temperature;
+    float charge_level;
+    uint16_t flags;
+};
+
+struct EventRecord
+{
+    EventId event;
+    uint8_t event_param1;
+    uint16_t flags;
+};
+
+// Tagged union: the type field selects which union member is valid
+struct DataItemRecord
+{
+    DataItemType type;
+    uint32_t timestamp; // Unix timestamp
+
+    union
+    {
+        RealTimeDataRecord real_time;
+        RawDataRecord raw;
+        DoseRateDBRecord dose_rate_db;
+        RareDataRecord rare;
+        EventRecord event;
+    };
+};
+
+// Fixed-capacity object pool for DataItem records decoded from DATA_BUF.
+// All items share a reset-per-poll lifetime: decode fills the pool, the
+// application walks the items, and the next poll releases everything at
+// once. This keeps the steady-state data path free of heap allocations,
+// which matters for long uptimes on the ESP32 where heap fragmentation
+// eventually breaks the BLE stack.
+class DataItemPool
+{
+    public:
+        // Large enough for a full 4KB DATA_BUF response of small records
+        static const size_t MAX_ITEMS = 128;
+
+        DataItemPool(void);
+        ~DataItemPool(void);
+
+        // Allocation methods - return nullptr when the pool is exhausted
+        RealTimeData* allocRealTimeData(void);
+        RawData* allocRawData(void);
+        DoseRateDB* allocDoseRateDB(void);
+        RareData* allocRareData(void);
+        Event* allocEvent(void);
+
+        // Release all items at once (per-poll lifetime)
+        void reset(void);
+
+        // Access to the decoded items in decode order
+        DataItem* itemAt(size_t index) const;
+        size_t used(void) const;
+        size_t capacity(void) const;
+
+    private:
+        // Slot size: large enough for the biggest DataItem subclass
+        static const size_t SLOT_SIZE_1 = (sizeof(RealTimeData) > sizeof(RawData)) ? sizeof(RealTimeData) : sizeof(RawData);
+        static const size_t SLOT_SIZE_2 = (SLOT_SIZE_1 > sizeof(DoseRateDB)) ? SLOT_SIZE_1 : sizeof(DoseRateDB);
+        static const size_t SLOT_SIZE_3 = (SLOT_SIZE_2 > sizeof(RareData)) ? SLOT_SIZE_2 : sizeof(RareData);
+        static const size_t SLOT_SIZE = (SLOT_SIZE_3 > sizeof(Event)) ? SLOT_SIZE_3 : sizeof(Event);
+
+        // Claim the next free slot, or nullptr when the pool is full
+        void* allocSlot(void);
+
+        // Raw slot storage, aligned for placement new of any DataItem subclass
+        alignas(8) uint8_t _storage[MAX_ITEMS * SLOT_SIZE];
+
+        // Constructed items in decode order (needed to run destructors on reset)
+        DataItem* _items[MAX_ITEMS];
+        size_t _used;
+};
+
 struct Spectrum
 {
     uint32_t duration_sec; // Duration in seconds
@@ -333,15 +455,13 @@ struct Spectrum
     float a1;
     float a2;
 
-    // Define a reasonable number of channels that won't overflow the ESP32 stack
-    static const size_t MAX_CHANNELS = 1024;
+    // Channel capacity, overridable from the build flags (see
+    // RADIACODE_MAX_CHANNELS at the top of this header)
+    static const size_t MAX_CHANNELS = RADIACODE_MAX_CHANNELS;
 
-    // Use a static array shared by all instances to avoid stack overflow
-    // This means only one spectrum can be processed at a time, but that's usually okay
-    static uint32_t shared_counts[MAX_CHANNELS];
-
-    // Fixed array to avoid any memory allocations/deallocations
-    // This is a pointer to the static array
+    // Per-instance channel array, heap-allocated so it stays off the stack.
+    // Each Spectrum owns its own counts, so several spectra (and several
+    // device connections) can be processed concurrently.
     uint32_t* counts;
 
     size_t count_size; // Number of valid elements in the counts array
@@ -349,7 +469,7 @@ struct Spectrum
     // Constructor
     Spectrum(void);
 
-    // Destructor - nothing to do with fixed arrays
+    // Destructor - releases the per-instance channel array
     ~Spectrum(void);
 
     // Copy constructor
@@ -368,6 +488,71 @@ struct Spectrum
     uint32_t at(size_t index) const;
 };
 
+// Cached per-channel energy calibration. Evaluating the calibration
+// polynomial a0 + a1*ch + a2*ch^2 for every channel of every spectrum adds
+// up to thousands of float multiplies per fetch, with coefficients that
+// essentially never change; this object computes the per-channel energy
+// (and channel width) tables once per (a0, a1, a2) triple and serves plain
+// array reads until the coefficients change. The contiguous tables also
+// give downstream binning code something to vectorize over.
+class EnergyCalibLUT
+{
+    public:
+        static const size_t MAX_CHANNELS = Spectrum::MAX_CHANNELS;
+
+        EnergyCalibLUT(void);
+        ~EnergyCalibLUT(void);
+
+        // Copy constructor and assignment operator (deep copy, so two
+        // caches never share their tables)
+        EnergyCalibLUT(const EnergyCalibLUT& other);
+        EnergyCalibLUT& operator=(const EnergyCalibLUT& other);
+
+        // Rebuild the tables when the triple differs from the cached one;
+        // a no-op when the coefficients are unchanged
+        void update(float a0, float a1, float a2);
+
+        // Drop the cached triple so the next update() rebuilds
+        void invalidate(void);
+        bool valid(void) const;
+
+        // Cached coefficients (only meaningful while valid)
+        float a0(void) const;
+        float a1(void) const;
+        float a2(void) const;
+
+        // Energy in keV at the given channel, and the keV span the channel
+        // covers; bounds-checked, returning 0 outside the table
+        float energy(size_t channel) const;
+        float width(size_t channel) const;
+
+        // Direct access to the contiguous tables (MAX_CHANNELS entries)
+        const float* energies(void) const;
+        const float* widths(void) const;
+
+    private:
+        // Heap tables so the object stays cheap to embed; 2 x 4 KB
+        float* _energy;
+        float* _width;
+        float _a0;
+        float _a1;
+        float _a2;
+        bool _valid;
+};
+
+// Allocation-free firmware version info: POD counterpart of the
+// std::tuple returned by RadiaCode::fwVersion(), with fixed char arrays
+// instead of heap-allocated Strings
+struct FwVersion
+{
+    int boot_major;
+    int boot_minor;
+    char boot_date[24];
+    int target_major;
+    int target_minor;
+    char target_date[24];
+};
+
 struct AlarmLimits
 {
     float l1_count_rate;
@@ -380,4 +565,77 @@ struct AlarmLimits
     String dose_unit;
 };
 
+// Alarm severity reported to the alarm callback
+enum AlarmLevel
+{
+    ALARM_NONE = 0,
+    ALARM_L1 = 1,
+    ALARM_L2 = 2
+};
+
+// Which quantity crossed its threshold
+enum AlarmSource
+{
+    ALARM_COUNT_RATE = 0,
+    ALARM_DOSE_RATE = 1
+};
+
+// Fired on every alarm level change (both raising and clearing), with the
+// sample value and record timestamp that caused the transition
+typedef void (*AlarmCallback)(AlarmSource source, AlarmLevel level, float value, uint32_t timestamp);
+
+// On-host alarm engine evaluated inline while DATA_BUF records are decoded,
+// so an over-threshold condition fires its callback within the same poll
+// cycle instead of after records have been shipped upstream and compared
+// there. Thresholds mirror the L1/L2 pairs of AlarmLimits and are compared
+// directly against the decoded RealTimeData/DoseRateDB values, so they must
+// be given in the same units the records carry (cps and the device's dose
+// rate unit). A negative threshold disables that limit. Hysteresis: once a
+// level is raised, the value must drop below threshold * (1 - hysteresis)
+// before the level clears, preventing callback chatter around the limit.
+class AlarmMonitor
+{
+    public:
+        AlarmMonitor(void);
+
+        // Configure thresholds; negative values disable the limit
+        void setLimits(float l1_count_rate, float l2_count_rate, float l1_dose_rate, float l2_dose_rate);
+        void setLimits(const AlarmLimits& limits);
+
+        // Fraction of the threshold the value must fall below before a
+        // raised level clears (default 0.1 = 10%)
+        void setHysteresis(float fraction);
+
+        void setCallback(AlarmCallback callback);
+
+        // True when at least one threshold is configured; the decoder skips
+        // evaluation entirely otherwise
+        bool enabled(void) const;
+
+        // Evaluate one sample; fires the callback on level transitions
+        void evaluateCountRate(float count_rate, uint32_t timestamp);
+        void evaluateDoseRate(float dose_rate, uint32_t timestamp);
+
+        // Current latched levels
+        AlarmLevel countRateLevel(void) const;
+        AlarmLevel doseRateLevel(void) const;
+
+        // Drop back to ALARM_NONE without firing the callback
+        void reset(void);
+
+    private:
+        // Classify a value against its L1/L2 pair with hysteresis relative
+        // to the currently latched level
+        AlarmLevel classify(float value, float l1, float l2, AlarmLevel current) const;
+
+        float _l1_count_rate;
+        float _l2_count_rate;
+        float _l1_dose_rate;
+        float _l2_dose_rate;
+        float _hysteresis;
+        AlarmCallback _callback;
+        AlarmLevel _count_rate_level;
+        AlarmLevel _dose_rate_level;
+};
+
 #endif
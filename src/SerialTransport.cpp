@@ -0,0 +1,158 @@
+/**********************************************************************************/
+/* Copyright (c) 2025 Markus Geiger                                               */
+/*                                                                                */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
+/* of this software and associated documentation files (the "Software"), to deal  */
+/* in the Software without restriction, including without limitation the rights   */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
+/* copies of the Software, and to permit persons to whom the Software is          */
+/* furnished to do so, subject to the following conditions:                       */
+/*                                                                                */
+/* The above copyright notice and this permission notice shall be included in all */
+/* copies or substantial portions of the Software.                                */
+/*                                                                                */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
+/* SOFTWARE.                                                                      */
+/**********************************************************************************/
+
+#include "SerialTransport.h"
+#include "RadiaCodePerf.h"
+
+// Debugging switches
+#undef  ST_DEBUG_INFO
+#define ST_DEBUG_WARNING
+#define ST_DEBUG_ERROR
+
+SerialTransport::SerialTransport(Stream& serial)
+{
+    _serial = &serial;
+    _resp_received = 0;
+    memset(_resp_buffer, 0, MAX_RESP_SIZE);
+}
+
+SerialTransport::~SerialTransport(void)
+{
+    // The Stream belongs to the sketch; nothing to release here
+    _serial = nullptr;
+}
+
+bool SerialTransport::readExact(uint8_t* dest, size_t length)
+{
+    size_t received = 0;
+    unsigned long last_data = millis();
+
+    while (received < length)
+    {
+        int available = _serial->available();
+        if (available > 0)
+        {
+            size_t to_read = (size_t)available;
+            if (to_read > (length - received))
+            {
+                to_read = length - received;
+            }
+            size_t got = _serial->readBytes(dest + received, to_read);
+            received += got;
+            last_data = millis();
+        }
+        else
+        {
+            if ((millis() - last_data) > RESPONSE_TIMEOUT_MS)
+            {
+#ifdef ST_DEBUG_ERROR
+                Serial.print("Error: Serial response timeout, got ");
+                Serial.print(received);
+                Serial.print(" of ");
+                Serial.print(length);
+                Serial.println(" bytes");
+#endif
+                return false;
+            }
+            delay(1);
+            yield();
+        }
+    }
+
+    return true;
+}
+
+BytesBuffer SerialTransport::execute(const uint8_t* request, size_t length)
+{
+    BytesBuffer response;
+
+    if ((_serial == nullptr) || (request == nullptr) || (length == 0))
+    {
+#ifdef ST_DEBUG_ERROR
+        Serial.println("Error: Invalid request in SerialTransport::execute()");
+#endif
+        return response;
+    }
+
+    // Drop stale bytes from an earlier command that timed out mid-response,
+    // so they cannot be mistaken for the new length prefix
+    while (_serial->available() > 0)
+    {
+        _serial->read();
+    }
+
+    // A wired link takes the whole frame in one write - no chunking
+    uint32_t perf_start = RadiaCodePerf::enabled() ? RadiaCodePerf::now() : 0;
+    size_t written = _serial->write(request, length);
+    _serial->flush();
+    if (written != length)
+    {
+#ifdef ST_DEBUG_ERROR
+        Serial.println("Error: Short write on serial transport");
+#endif
+        return response;
+    }
+
+    if (RadiaCodePerf::enabled())
+    {
+        uint32_t perf_sent = RadiaCodePerf::now();
+        RadiaCodePerf::record(PERF_TRANSPORT_WRITE, perf_sent - perf_start);
+        perf_start = perf_sent; // The wait phase starts here
+    }
+
+    // Response: 4-byte length prefix, then that many payload bytes
+    _resp_received = 0;
+    if (!readExact(_resp_buffer, 4))
+    {
+        return response;
+    }
+
+    uint32_t resp_size = (uint32_t)_resp_buffer[0] | ((uint32_t)_resp_buffer[1] << 8) |
+        ((uint32_t)_resp_buffer[2] << 16) | ((uint32_t)_resp_buffer[3] << 24);
+
+    if (resp_size > (MAX_RESP_SIZE - 4))
+    {
+#ifdef ST_DEBUG_WARNING
+        Serial.print("Warning: Response size too large (");
+        Serial.print(resp_size);
+        Serial.print(" bytes), limiting to ");
+        Serial.println(MAX_RESP_SIZE - 4);
+#endif
+        resp_size = MAX_RESP_SIZE - 4;
+    }
+
+    if (!readExact(_resp_buffer + 4, resp_size))
+    {
+        return response;
+    }
+    _resp_received = resp_size + 4;
+
+    if (RadiaCodePerf::enabled())
+    {
+        RadiaCodePerf::record(PERF_TRANSPORT_WAIT, RadiaCodePerf::now() - perf_start);
+    }
+
+    // Zero-copy view over the payload, same lifetime rules as the BLE
+    // transport: valid until the next request starts
+    response = BytesBuffer::view(_resp_buffer + 4, resp_size);
+    return response;
+}
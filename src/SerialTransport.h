@@ -0,0 +1,65 @@
+/**********************************************************************************/
+/* Copyright (c) 2025 Markus Geiger                                               */
+/*                                                                                */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
+/* of this software and associated documentation files (the "Software"), to deal  */
+/* in the Software without restriction, including without limitation the rights   */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
+/* copies of the Software, and to permit persons to whom the Software is          */
+/* furnished to do so, subject to the following conditions:                       */
+/*                                                                                */
+/* The above copyright notice and this permission notice shall be included in all */
+/* copies or substantial portions of the Software.                                */
+/*                                                                                */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
+/* SOFTWARE.                                                                      */
+/**********************************************************************************/
+
+#ifndef SerialTransport_h
+#define SerialTransport_h
+
+#include "RadiaCodeTransport.h"
+#include "BytesBuffer.h"
+
+// Wired transport for detectors sitting in a cradle: speaks the same
+// length-prefixed frame protocol as the Bluetooth transport, but over an
+// Arduino Stream (a hardware UART wired to the device's USB bridge, or
+// native USB CDC). No chunking, no notification reassembly and no radio
+// wait - a command round trip is limited only by the link's baud rate, so
+// bench and kiosk deployments get spectrum pulls an order of magnitude
+// faster than BLE without touching any higher-level code.
+class SerialTransport : public RadiaCodeTransport
+{
+    public:
+        // The Stream must already be opened (begin() called) by the sketch;
+        // the transport does not own it
+        SerialTransport(Stream& serial);
+        virtual ~SerialTransport(void);
+        virtual BytesBuffer execute(const uint8_t* request, size_t length) override;
+
+    private:
+        // Read exactly 'length' bytes into 'dest', giving up when the line
+        // stays idle longer than the inter-byte timeout
+        bool readExact(uint8_t* dest, size_t length);
+
+        // A wired link answers within milliseconds; the generous budget
+        // only matters when the cable is unplugged mid-command
+        static const uint32_t RESPONSE_TIMEOUT_MS = 3000;
+
+        Stream* _serial;
+
+        // Per-instance response buffer, same sizing as the BLE transport.
+        // execute() returns a zero-copy view over it, valid until the next
+        // request starts writing - which RadiaCode's execute-then-decode
+        // flow guarantees.
+        static const size_t MAX_RESP_SIZE = 4096;
+        uint8_t _resp_buffer[MAX_RESP_SIZE];
+        size_t _resp_received;
+};
+
+#endif
@@ -0,0 +1,407 @@
+/**********************************************************************************/
+/* Copyright (c) 2025 Markus Geiger                                               */
+/*                                                                                */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
+/* of this software and associated documentation files (the "Software"), to deal  */
+/* in the Software without restriction, including without limitation the rights   */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
+/* copies of the Software, and to permit persons to whom the Software is          */
+/* furnished to do so, subject to the following conditions:                       */
+/*                                                                                */
+/* The above copyright notice and this permission notice shall be included in all */
+/* copies or substantial portions of the Software.                                */
+/*                                                                                */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
+/* SOFTWARE.                                                                      */
+/**********************************************************************************/
+
+#include "SpectrumLogger.h"
+#include "BytesBuffer.h"
+#include "Decoders.h"
+
+// Debugging switches
+#undef  SL_DEBUG_INFO
+#define SL_DEBUG_WARNING
+#define SL_DEBUG_ERROR
+
+// Delta width class for one channel value, matching the V1 decoder's vlen
+// variants: 0 = zero run, 2/3/4/5 = int8/int16/int24/int32 delta. The
+// absolute-uint8 variant (vlen 1) is never emitted; deltas cover it.
+static uint8_t classifyDelta(uint32_t value, uint32_t last)
+{
+    if (value == 0)
+    {
+        return 0;
+    }
+
+    int64_t delta = (int64_t)value - (int64_t)last;
+    if ((delta >= -128) && (delta <= 127))
+    {
+        return 2;
+    }
+    if ((delta >= -32768) && (delta <= 32767))
+    {
+        return 3;
+    }
+    if ((delta >= -8388608) && (delta <= 8388607))
+    {
+        return 4;
+    }
+    return 5;
+}
+
+// Encoded bytes per value for each class
+static const uint8_t CLASS_BYTES[6] = {0, 1, 1, 2, 3, 4};
+
+size_t SpectrumLogger::encode(const Spectrum& spectrum, uint8_t* out, size_t out_size)
+{
+    if ((out == nullptr) || (out_size < 16))
+    {
+        return 0;
+    }
+
+    // Record header: duration and the calibration coefficients, laid out
+    // exactly like the device's spectrum payload
+    uint32_t duration = spectrum.duration_sec;
+    memcpy(out, &duration, 4);
+    memcpy(out + 4, &spectrum.a0, 4);
+    memcpy(out + 8, &spectrum.a1, 4);
+    memcpy(out + 12, &spectrum.a2, 4);
+
+    size_t pos = 16;
+    size_t i = 0;
+    uint32_t last = 0;
+
+    while (i < spectrum.count_size)
+    {
+        // Grow a run of channels sharing one width class. A few narrower
+        // deltas ride along in a wider run (they still fit), so a single
+        // outlier does not split an otherwise uniform block - but a long
+        // narrower tail ends the run, since it compresses better on its
+        // own than padded to the wide class.
+        uint8_t cls = classifyDelta(spectrum.counts[i], last);
+        size_t run_start = i;
+        uint32_t run_prev = last;
+        size_t narrow_streak = 0;
+
+        while ((i < spectrum.count_size) && ((i - run_start) < 4095))
+        {
+            uint8_t c = classifyDelta(spectrum.counts[i], run_prev);
+            bool fits = (cls == 0) ? (c == 0) : ((c != 0) && (c <= cls));
+            if (!fits)
+            {
+                break;
+            }
+            if ((cls != 0) && (c < cls))
+            {
+                narrow_streak++;
+                if (narrow_streak >= 4)
+                {
+                    // Hand the streak to the next, narrower run
+                    i -= narrow_streak - 1;
+                    break;
+                }
+            }
+            else
+            {
+                narrow_streak = 0;
+            }
+            run_prev = spectrum.counts[i];
+            i++;
+        }
+
+        uint16_t cnt = (uint16_t)(i - run_start);
+        size_t vbytes = CLASS_BYTES[cls];
+
+        if ((pos + 2 + (size_t)cnt * vbytes) > out_size)
+        {
+#ifdef SL_DEBUG_ERROR
+            Serial.println("Error: Encode buffer too small for spectrum record");
+#endif
+            return 0;
+        }
+
+        // Block header: value count and encoding variant
+        uint16_t header = (uint16_t)((cnt << 4) | cls);
+        out[pos++] = (uint8_t)(header & 0xFF);
+        out[pos++] = (uint8_t)(header >> 8);
+
+        // Value payload (zero runs carry none)
+        for (size_t j = run_start; (cls != 0) && (j < i); j++)
+        {
+            int32_t delta = (int32_t)((int64_t)spectrum.counts[j] - (int64_t)last);
+            switch (cls)
+            {
+                case 2:
+                    out[pos++] = (uint8_t)(int8_t)delta;
+                    break;
+
+                case 3:
+                    out[pos++] = (uint8_t)(delta & 0xFF);
+                    out[pos++] = (uint8_t)((delta >> 8) & 0xFF);
+                    break;
+
+                case 4:
+                    out[pos++] = (uint8_t)(delta & 0xFF);
+                    out[pos++] = (uint8_t)((delta >> 8) & 0xFF);
+                    out[pos++] = (uint8_t)((delta >> 16) & 0xFF);
+                    break;
+
+                case 5:
+                    out[pos++] = (uint8_t)(delta & 0xFF);
+                    out[pos++] = (uint8_t)((delta >> 8) & 0xFF);
+                    out[pos++] = (uint8_t)((delta >> 16) & 0xFF);
+                    out[pos++] = (uint8_t)((delta >> 24) & 0xFF);
+                    break;
+            }
+            last = spectrum.counts[j];
+        }
+
+        // A zero run resets the delta base, mirroring the decoder; after a
+        // delta run the payload loop left last on the final channel
+        if (cls == 0)
+        {
+            last = 0;
+        }
+    }
+
+    return pos;
+}
+
+bool SpectrumLogger::decode(const uint8_t* data, size_t length, Spectrum& spectrum_out)
+{
+    if ((data == nullptr) || (length < 16))
+    {
+        return false;
+    }
+
+    // The payload is exactly the device's V1 spectrum layout, so the stock
+    // decoder does the work on a zero-copy view
+    BytesBuffer view = BytesBuffer::view(data, length);
+    decodeSpectrum(view, 1, spectrum_out);
+    return true;
+}
+
+SpectrumLogger::SpectrumLogger(Print& out)
+{
+    _out = &out;
+    _buffers[0] = nullptr;
+    _buffers[1] = nullptr;
+    _sizes[0] = 0;
+    _sizes[1] = 0;
+    _busy[0] = false;
+    _busy[1] = false;
+    _dropped = 0;
+
+#if defined(ARDUINO_ARCH_ESP32)
+    _writer_task = nullptr;
+    _write_queue = nullptr;
+    _writer_run = false;
+#endif
+}
+
+SpectrumLogger::~SpectrumLogger(void)
+{
+    end();
+    _out = nullptr;
+}
+
+bool SpectrumLogger::begin(void)
+{
+    if (_buffers[0] != nullptr)
+    {
+        return true; // Already started
+    }
+
+    _buffers[0] = new uint8_t[ENCODE_BUF_SIZE];
+    _buffers[1] = new uint8_t[ENCODE_BUF_SIZE];
+    _busy[0] = false;
+    _busy[1] = false;
+    _dropped = 0;
+
+#if defined(ARDUINO_ARCH_ESP32)
+    _write_queue = xQueueCreate(2, sizeof(size_t));
+    if (_write_queue == nullptr)
+    {
+        end();
+        return false;
+    }
+
+    // Write on core 0 so flash latency lands next to the radio work, not
+    // in the application loop
+    _writer_run = true;
+    BaseType_t created = xTaskCreatePinnedToCore(
+        writerTaskEntry,
+        "rc_splog",
+        4096,
+        this,
+        1,
+        &_writer_task,
+        0);
+
+    if (created != pdPASS)
+    {
+#ifdef SL_DEBUG_ERROR
+        Serial.println("Error: Failed to create spectrum log writer task");
+#endif
+        _writer_task = nullptr;
+        _writer_run = false;
+        end();
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+void SpectrumLogger::end(void)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    if (_writer_task != nullptr)
+    {
+        // The task drains the queue, then clears its handle on the way out
+        _writer_run = false;
+        while (_writer_task != nullptr)
+        {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+    _writer_run = false;
+
+    if (_write_queue != nullptr)
+    {
+        vQueueDelete(_write_queue);
+        _write_queue = nullptr;
+    }
+#endif
+
+    // Anything still marked busy was never written; it is lost with the
+    // buffers, which only happens on teardown
+    for (size_t i = 0; i < 2; i++)
+    {
+        if (_buffers[i] != nullptr)
+        {
+            delete[] _buffers[i];
+            _buffers[i] = nullptr;
+        }
+        _sizes[i] = 0;
+        _busy[i] = false;
+    }
+}
+
+bool SpectrumLogger::log(const Spectrum& spectrum)
+{
+    if ((_buffers[0] == nullptr) || (_out == nullptr))
+    {
+        return false; // Not started
+    }
+
+    // Pick a buffer the writer is not using
+    size_t index = 2;
+    if (!_busy[0])
+    {
+        index = 0;
+    }
+    else if (!_busy[1])
+    {
+        index = 1;
+    }
+
+    if (index == 2)
+    {
+        // Both buffers are waiting on flash: drop rather than stall the
+        // acquisition path
+        _dropped = _dropped + 1;
+#ifdef SL_DEBUG_WARNING
+        Serial.println("Warning: Spectrum log writer saturated, record dropped");
+#endif
+        return false;
+    }
+
+    size_t encoded = encode(spectrum, _buffers[index], ENCODE_BUF_SIZE);
+    if (encoded == 0)
+    {
+        return false;
+    }
+    _sizes[index] = encoded;
+
+#if defined(ARDUINO_ARCH_ESP32)
+    if (_write_queue != nullptr)
+    {
+        _busy[index] = true;
+        if (xQueueSend(_write_queue, &index, 0) != pdTRUE)
+        {
+            // Queue full despite a free buffer; should not happen with a
+            // depth matching the buffer count, but recover cleanly
+            _busy[index] = false;
+            _dropped = _dropped + 1;
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    // Synchronous fallback (non-ESP32, or no queue)
+    writeRecord(_buffers[index], encoded);
+    return true;
+}
+
+uint32_t SpectrumLogger::dropped(void) const
+{
+    return _dropped;
+}
+
+void SpectrumLogger::writeRecord(const uint8_t* payload, size_t length)
+{
+    // Frame: magic, payload length, payload
+    uint8_t frame[4];
+    frame[0] = (uint8_t)(RECORD_MAGIC & 0xFF);
+    frame[1] = (uint8_t)(RECORD_MAGIC >> 8);
+    frame[2] = (uint8_t)(length & 0xFF);
+    frame[3] = (uint8_t)((length >> 8) & 0xFF);
+
+    _out->write(frame, sizeof(frame));
+    _out->write(payload, length);
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+void SpectrumLogger::writerTaskEntry(void* param)
+{
+    SpectrumLogger* self = (SpectrumLogger*)param;
+
+    if (self != nullptr)
+    {
+        self->writerTaskLoop();
+        // Signal end() that the buffers are no longer touched
+        self->_writer_task = nullptr;
+    }
+
+    vTaskDelete(nullptr);
+}
+
+void SpectrumLogger::writerTaskLoop(void)
+{
+    while (true)
+    {
+        size_t index;
+        if (xQueueReceive(_write_queue, &index, pdMS_TO_TICKS(100)) == pdTRUE)
+        {
+            if ((index < 2) && _busy[index])
+            {
+                writeRecord(_buffers[index], _sizes[index]);
+                _busy[index] = false;
+            }
+        }
+        else if (!_writer_run)
+        {
+            // Stop only once the queue has drained, so end() flushes
+            break;
+        }
+    }
+}
+#endif
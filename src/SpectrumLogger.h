@@ -0,0 +1,103 @@
+/**********************************************************************************/
+/* Copyright (c) 2025 Markus Geiger                                               */
+/*                                                                                */
+/* Permission is hereby granted, free of charge, to any person obtaining a copy   */
+/* of this software and associated documentation files (the "Software"), to deal  */
+/* in the Software without restriction, including without limitation the rights   */
+/* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell      */
+/* copies of the Software, and to permit persons to whom the Software is          */
+/* furnished to do so, subject to the following conditions:                       */
+/*                                                                                */
+/* The above copyright notice and this permission notice shall be included in all */
+/* copies or substantial portions of the Software.                                */
+/*                                                                                */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     */
+/* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       */
+/* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    */
+/* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         */
+/* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  */
+/* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  */
+/* SOFTWARE.                                                                      */
+/**********************************************************************************/
+
+#ifndef SpectrumLogger_h
+#define SpectrumLogger_h
+
+#include "Arduino.h"
+#include "RadiaCodeTypes.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#endif
+
+// Compact spectrum logging to SD/SPIFFS. A naively serialized Spectrum
+// costs 4 KB per sample; this logger re-encodes the counts with the same
+// run/delta scheme the device's V1 spectrum format uses (zero runs and
+// int8/int16/int24/int32 deltas), which typically shrinks a sample by an
+// order of magnitude. Each record is framed with a magic word and length,
+// carries the duration/a0/a1/a2 header, and its payload is decodable by
+// the stock decodeSpectrum() with format version 1 - no second decoder to
+// maintain.
+//
+// On the ESP32 the writer is double-buffered and asynchronous: log()
+// encodes into a free buffer and queues it, a background task pushes it
+// to flash, so storage latency never stalls acquisition. When both
+// buffers are waiting on flash the record is dropped and counted rather
+// than blocking. On other platforms log() writes synchronously.
+class SpectrumLogger
+{
+    public:
+        // Record framing on flash: magic, payload length, payload
+        static const uint16_t RECORD_MAGIC = 0x5253; // "SR" little-endian
+
+        // The output (an SD or SPIFFS File, or any Print) must stay open
+        // until end(); the logger does not own it
+        SpectrumLogger(Print& out);
+        ~SpectrumLogger(void);
+
+        // Allocate the encode buffers and start the background writer
+        bool begin(void);
+        // Flush pending records, stop the writer and release the buffers
+        void end(void);
+
+        // Encode one spectrum and hand it to the writer. Returns false if
+        // it was dropped (writer saturated or logger not started).
+        bool log(const Spectrum& spectrum);
+
+        // Records dropped because both buffers were waiting on flash
+        uint32_t dropped(void) const;
+
+        // Codec, also usable standalone. encode() writes the record
+        // payload (16-byte header plus run/delta counts) and returns its
+        // size, 0 if the buffer is too small; decode() is the inverse and
+        // accepts exactly what encode() produced.
+        static size_t encode(const Spectrum& spectrum, uint8_t* out, size_t out_size);
+        static bool decode(const uint8_t* data, size_t length, Spectrum& spectrum_out);
+
+    private:
+        // Worst case: every channel in its own block (2-byte header plus a
+        // 4-byte delta) after the 16-byte record header
+        static const size_t ENCODE_BUF_SIZE = 16 + Spectrum::MAX_CHANNELS * 6;
+
+        // Write one framed record to the output
+        void writeRecord(const uint8_t* payload, size_t length);
+
+        Print* _out;
+        uint8_t* _buffers[2]; // Allocated while the logger runs
+        size_t _sizes[2];
+        volatile bool _busy[2]; // Encoded, waiting for the writer
+        volatile uint32_t _dropped;
+
+#if defined(ARDUINO_ARCH_ESP32)
+        TaskHandle_t _writer_task;
+        QueueHandle_t _write_queue;
+        volatile bool _writer_run;
+
+        static void writerTaskEntry(void* param);
+        void writerTaskLoop(void);
+#endif
+};
+
+#endif